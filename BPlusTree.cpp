@@ -0,0 +1,462 @@
+//
+// B+tree index of bids by integer id
+//
+
+#include <algorithm>
+#include <iostream>
+#include <climits>
+#include <stdexcept>
+#include <vector>
+#include <string>
+
+#include "CSVparser.hpp"
+
+using namespace std;
+
+//============================================================================
+// B+ Tree class definition
+//============================================================================
+
+/**
+ * Class containing data members and methods to implement a B+tree keyed
+ * on the integer bid id.
+ *
+ * Inner nodes hold nothing but keys and child pointers, so one node
+ * covers many ids in a few cache lines and a lookup touches only a
+ * handful of nodes. Leaves hold the keys with the position of each bid
+ * in a packed vector of Record, Bid or CompactBid, and are linked to
+ * their neighbours so a range of ids is read by walking along the leaves
+ * in order.
+ */
+template <typename Record>
+class BPlusTreeOf {
+
+private:
+    static const unsigned int INNER_KEYS = 63;
+    static const unsigned int LEAF_KEYS = 64;
+    static const int MAX_HEIGHT = 32;
+
+    struct Inner {
+        unsigned int count;
+        unsigned int keys[INNER_KEYS];
+        // children[i] holds the ids below keys[i], the last child the rest
+        void* children[INNER_KEYS + 1];
+    };
+
+    struct Leaf {
+        unsigned int count;
+        unsigned int keys[LEAF_KEYS];
+        unsigned int values[LEAF_KEYS];
+        Leaf* prev;
+        Leaf* next;
+    };
+
+    void* root;
+    // number of levels, the bottom one being leaves
+    int height;
+    vector<Record> bids;
+    Leaf* findLeaf(unsigned int key) const;
+    void freeNode(void* node, int level);
+    static Leaf* newLeaf();
+
+public:
+    BPlusTreeOf();
+    virtual ~BPlusTreeOf();
+    BPlusTreeOf(const BPlusTreeOf&) = delete;
+    BPlusTreeOf& operator=(const BPlusTreeOf&) = delete;
+    void Insert(Bid bid);
+    void BulkLoad(vector<Bid> bids);
+    Bid Search(string bidId) const;
+    template <typename Visitor> void Range(unsigned int first, unsigned int last, Visitor visit) const;
+    unsigned int Count() const;
+    int Height() const;
+    static unsigned int getStringKey(string bidId);
+    static int loadBids(string, BPlusTreeOf*);
+    static int bulkLoadBids(string, BPlusTreeOf*);
+};
+
+using BPlusTree = BPlusTreeOf<Bid>;
+
+/**
+ * Default constructor
+ */
+template <typename Record>
+BPlusTreeOf<Record>::BPlusTreeOf() {
+    root = newLeaf();
+    height = 1;
+}
+
+/**
+ * Destructor
+ */
+template <typename Record>
+BPlusTreeOf<Record>::~BPlusTreeOf() {
+    freeNode(root, height);
+}
+
+/**
+ * Allocate an empty leaf with no neighbours
+ */
+template <typename Record>
+typename BPlusTreeOf<Record>::Leaf* BPlusTreeOf<Record>::newLeaf() {
+    Leaf* leaf = new Leaf;
+    leaf->count = 0;
+    leaf->prev = nullptr;
+    leaf->next = nullptr;
+    return leaf;
+}
+
+/**
+ * Free a node and everything below it
+ * @param node the node to free
+ * @param level levels from the node down to the leaves, 1 for a leaf
+ */
+template <typename Record>
+void BPlusTreeOf<Record>::freeNode(void* node, int level) {
+    if (level == 1) {
+        delete static_cast<Leaf*>(node);
+        return;
+    }
+    Inner* inner = static_cast<Inner*>(node);
+    for (unsigned int i = 0; i <= inner->count; ++i) {
+        freeNode(inner->children[i], level - 1);
+    }
+    delete inner;
+}
+
+/**
+ * Method to get the int value of the bid id from bid id string
+ * @param bidId bid id we would like to know int value for
+ * @return int value of bid id
+ */
+template <typename Record>
+unsigned int BPlusTreeOf<Record>::getStringKey(string bidId) {
+    unsigned long long temp;
+    if (!parseUnsigned(bidId, temp) || temp > UINT_MAX) {
+        throw invalid_argument("bid id " + bidId + " is not numeric");
+    }
+    return (unsigned int) temp;
+}
+
+/**
+ * Walk down to the leaf a key belongs in
+ * @param key the bid id to look for
+ * @return the leaf holding the key, or where it would go
+ */
+template <typename Record>
+typename BPlusTreeOf<Record>::Leaf* BPlusTreeOf<Record>::findLeaf(unsigned int key) const {
+    void* node = root;
+    for (int level = height; level > 1; --level) {
+        const Inner* inner = static_cast<const Inner*>(node);
+        unsigned int child = upper_bound(inner->keys, inner->keys + inner->count, key) - inner->keys;
+        node = inner->children[child];
+    }
+    return static_cast<Leaf*>(node);
+}
+
+/**
+ * Insert a bid, replacing any bid with the same id
+ *
+ * @param bid The bid to insert
+ */
+template <typename Record>
+void BPlusTreeOf<Record>::Insert(Bid bid) {
+    unsigned int key = getStringKey(bid.bidId);
+
+    // walk down remembering each inner node and the child taken
+    Inner* path[MAX_HEIGHT];
+    unsigned int taken[MAX_HEIGHT];
+    void* node = root;
+    for (int level = height; level > 1; --level) {
+        Inner* inner = static_cast<Inner*>(node);
+        unsigned int child = upper_bound(inner->keys, inner->keys + inner->count, key) - inner->keys;
+        path[height - level] = inner;
+        taken[height - level] = child;
+        node = inner->children[child];
+    }
+
+    Leaf* leaf = static_cast<Leaf*>(node);
+    unsigned int position = lower_bound(leaf->keys, leaf->keys + leaf->count, key) - leaf->keys;
+    if (position < leaf->count && leaf->keys[position] == key) {
+        bids[leaf->values[position]] = packBid<Record>(move(bid));
+        return;
+    }
+    unsigned int value = bids.size();
+    bids.push_back(packBid<Record>(move(bid)));
+
+    // split a full leaf in half, the new right leaf's first key goes up
+    unsigned int separator = 0;
+    void* split = nullptr;
+    if (leaf->count == LEAF_KEYS) {
+        Leaf* right = newLeaf();
+        unsigned int half = LEAF_KEYS / 2;
+        right->count = LEAF_KEYS - half;
+        copy(leaf->keys + half, leaf->keys + LEAF_KEYS, right->keys);
+        copy(leaf->values + half, leaf->values + LEAF_KEYS, right->values);
+        leaf->count = half;
+        right->prev = leaf;
+        right->next = leaf->next;
+        if (leaf->next != nullptr) {
+            leaf->next->prev = right;
+        }
+        leaf->next = right;
+
+        if (position > half) {
+            position -= half;
+            leaf = right;
+        }
+        separator = right->keys[0];
+        split = right;
+    }
+    copy_backward(leaf->keys + position, leaf->keys + leaf->count, leaf->keys + leaf->count + 1);
+    copy_backward(leaf->values + position, leaf->values + leaf->count, leaf->values + leaf->count + 1);
+    leaf->keys[position] = key;
+    leaf->values[position] = value;
+    leaf->count++;
+
+    // add each split to the parent, splitting full parents on the way up
+    for (int depth = height - 2; depth >= 0 && split != nullptr; --depth) {
+        Inner* inner = path[depth];
+        unsigned int child = taken[depth];
+        unsigned int keys[INNER_KEYS + 1];
+        void* children[INNER_KEYS + 2];
+
+        // build the node as it would be with room for the new key
+        copy(inner->keys, inner->keys + child, keys);
+        keys[child] = separator;
+        copy(inner->keys + child, inner->keys + inner->count, keys + child + 1);
+        copy(inner->children, inner->children + child + 1, children);
+        children[child + 1] = split;
+        copy(inner->children + child + 1, inner->children + inner->count + 1, children + child + 2);
+        unsigned int count = inner->count + 1;
+
+        if (count <= INNER_KEYS) {
+            copy(keys, keys + count, inner->keys);
+            copy(children, children + count + 1, inner->children);
+            inner->count = count;
+            split = nullptr;
+        } else {
+            // the middle key moves up, the keys either side of it stay
+            unsigned int half = count / 2;
+            Inner* right = new Inner;
+            inner->count = half;
+            copy(keys, keys + half, inner->keys);
+            copy(children, children + half + 1, inner->children);
+            right->count = count - half - 1;
+            copy(keys + half + 1, keys + count, right->keys);
+            copy(children + half + 1, children + count + 1, right->children);
+            separator = keys[half];
+            split = right;
+        }
+    }
+
+    // the root itself split, so the tree grows a level
+    if (split != nullptr) {
+        Inner* top = new Inner;
+        top->count = 1;
+        top->keys[0] = separator;
+        top->children[0] = root;
+        top->children[1] = split;
+        root = top;
+        height++;
+    }
+}
+
+/**
+ * Replace the contents of the tree with a set of bids, building it
+ * bottom up in one pass: the bids are laid out in full leaves, then
+ * each level of inner nodes is built over the one below it. Bids that
+ * are not already in order of id are sorted first, and when an id
+ * appears more than once the last bid wins, as it would with Insert.
+ * @param bids the bids to load
+ */
+template <typename Record>
+void BPlusTreeOf<Record>::BulkLoad(vector<Bid> bids) {
+    vector<pair<unsigned int, unsigned int>> keys;
+    keys.reserve(bids.size());
+    for (unsigned int i = 0; i < bids.size(); ++i) {
+        keys.push_back({getStringKey(bids[i].bidId), i});
+    }
+    if (!is_sorted(keys.begin(), keys.end())) {
+        sort(keys.begin(), keys.end());
+    }
+    // keep the last of each run of equal ids
+    size_t unique = 0;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (i + 1 < keys.size() && keys[i + 1].first == keys[i].first) {
+            continue;
+        }
+        keys[unique++] = keys[i];
+    }
+    keys.resize(unique);
+
+    // pack the bids in id order so range scans read them in sequence
+    vector<Record> packed;
+    packed.reserve(keys.size());
+    for (auto& key : keys) {
+        packed.push_back(packBid<Record>(move(bids[key.second])));
+        key.second = packed.size() - 1;
+    }
+    freeNode(root, height);
+    this->bids = move(packed);
+
+    // spread the keys evenly so no node is left nearly empty
+    vector<void*> level;
+    vector<unsigned int> lowest;
+    size_t nodes = max<size_t>(1, (keys.size() + LEAF_KEYS - 1) / LEAF_KEYS);
+    Leaf* prev = nullptr;
+    for (size_t n = 0; n < nodes; ++n) {
+        size_t first = keys.size() * n / nodes;
+        size_t last = keys.size() * (n + 1) / nodes;
+        Leaf* leaf = newLeaf();
+        for (size_t i = first; i < last; ++i) {
+            leaf->keys[leaf->count] = keys[i].first;
+            leaf->values[leaf->count] = keys[i].second;
+            leaf->count++;
+        }
+        leaf->prev = prev;
+        if (prev != nullptr) {
+            prev->next = leaf;
+        }
+        prev = leaf;
+        level.push_back(leaf);
+        lowest.push_back(leaf->count > 0 ? leaf->keys[0] : 0);
+    }
+
+    height = 1;
+    while (level.size() > 1) {
+        vector<void*> parents;
+        vector<unsigned int> parentLowest;
+        nodes = (level.size() + INNER_KEYS) / (INNER_KEYS + 1);
+        for (size_t n = 0; n < nodes; ++n) {
+            size_t first = level.size() * n / nodes;
+            size_t last = level.size() * (n + 1) / nodes;
+            Inner* inner = new Inner;
+            inner->count = last - first - 1;
+            for (size_t i = first; i < last; ++i) {
+                inner->children[i - first] = level[i];
+                if (i > first) {
+                    inner->keys[i - first - 1] = lowest[i];
+                }
+            }
+            parents.push_back(inner);
+            parentLowest.push_back(lowest[first]);
+        }
+        level.swap(parents);
+        lowest.swap(parentLowest);
+        height++;
+    }
+    root = level[0];
+}
+
+/**
+ * Search for the specified bidId
+ *
+ * @param bidId The bid id to search for
+ * @return the bid, or an empty bid if it is not found
+ */
+template <typename Record>
+Bid BPlusTreeOf<Record>::Search(string bidId) const {
+    unsigned int key = getStringKey(bidId);
+    const Leaf* leaf = findLeaf(key);
+    unsigned int position = lower_bound(leaf->keys, leaf->keys + leaf->count, key) - leaf->keys;
+    if (position < leaf->count && leaf->keys[position] == key) {
+        return toBid(bids[leaf->values[position]]);
+    }
+    return Bid();
+}
+
+/**
+ * Visit every bid with an id from first to last, in id order
+ *
+ * @param first the lowest bid id to visit
+ * @param last the highest bid id to visit
+ * @param visit called with each bid
+ */
+template <typename Record>
+template <typename Visitor>
+void BPlusTreeOf<Record>::Range(unsigned int first, unsigned int last, Visitor visit) const {
+    const Leaf* leaf = findLeaf(first);
+    unsigned int position = lower_bound(leaf->keys, leaf->keys + leaf->count, first) - leaf->keys;
+    for (; leaf != nullptr; leaf = leaf->next, position = 0) {
+        for (; position < leaf->count; ++position) {
+            if (leaf->keys[position] > last) {
+                return;
+            }
+            visit(toBid(bids[leaf->values[position]]));
+        }
+    }
+}
+
+/**
+ * Number of bids in the tree
+ */
+template <typename Record>
+unsigned int BPlusTreeOf<Record>::Count() const {
+    return bids.size();
+}
+
+/**
+ * Number of levels in the tree, counting the leaves
+ */
+template <typename Record>
+int BPlusTreeOf<Record>::Height() const {
+    return height;
+}
+
+/**
+ * Load a CSV file containing bids into a container
+ *
+ * @param csvPath the path to the CSV file to load
+ * @param tree the tree to add the bids to
+ * @return the number of bids read
+ */
+template <typename Record>
+int BPlusTreeOf<Record>::loadBids(string csvPath, BPlusTreeOf* tree) {
+    int numBids = 0;
+
+    // initialize the CSV Reader, rows are parsed one at a time as they are loaded
+    // and only the bid columns are kept
+    csv::Reader file = csv::Reader(csvPath, csv::eMMAP, ',', BID_COLUMNS);
+
+    try {
+        // loop to read rows of a CSV file
+        while (file.next()) {
+
+            // Create a data structure and add to the collection of bids
+            Bid bid;
+            bid.bidId = string(file[BID_ID]);
+            bid.title = string(file[TITLE]);
+            bid.fund = string(file[FUND]);
+            bid.datePaid = string(file[DATE_PAID]);
+            bid.receiptNumber = string(file[RECEIPT_NUMBER]);
+            bid.netSales = currencyToDouble(file[NET_SALES]);
+            bid.amount = currencyToDouble(file[AMOUNT]);
+
+            // push this bid to the end
+            tree->Insert(move(bid));
+            numBids++;
+        }
+    } catch (csv::Error &e) {
+        cerr << e.what() << endl;
+    }
+    return numBids;
+}
+
+/**
+ * Load a CSV file containing bids and build the tree from them in one
+ * pass with BulkLoad, replacing what it held. Faster than loadBids, but
+ * every bid is held in memory until the file has been read, where
+ * loadBids only ever holds one row.
+ *
+ * @param csvPath the path to the CSV file to load
+ * @param tree the tree to build
+ * @return the number of bids read
+ */
+template <typename Record>
+int BPlusTreeOf<Record>::bulkLoadBids(string csvPath, BPlusTreeOf* tree) {
+    vector<Bid> bids = VectorSort::loadBids(csvPath);
+    int numBids = bids.size();
+    tree->BulkLoad(move(bids));
+    return numBids;
+}
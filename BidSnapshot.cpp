@@ -0,0 +1,256 @@
+//
+// Binary snapshot of a bid collection
+//
+
+#include <algorithm>
+#include <iostream>
+#include <cstdio>
+#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <vector>
+#include <string>
+#include <sys/stat.h>
+
+#include "CSVparser.hpp"
+
+using namespace std;
+
+//============================================================================
+// Bid Snapshot class definition
+//============================================================================
+
+/**
+ * Class containing data members and methods to save a collection of bids
+ * to a compact binary file and map it back without parsing anything.
+ *
+ * Layout (native byte order):
+ *   Header   magic, bid count, offset and size of the string heap
+ *   Record   one fixed-width entry per bid: integer id, amounts and
+ *            offset/length pairs pointing into the string heap
+ *   Heap     the text of every title, fund, date and receipt number,
+ *            each distinct string stored once
+ */
+class BidSnapshot {
+
+private:
+    struct Text {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    struct Record {
+        uint32_t bidId;
+        uint32_t reserved;
+        double amount;
+        double netSales;
+        Text title;
+        Text fund;
+        Text datePaid;
+        Text receiptNumber;
+    };
+
+    struct Header {
+        char magic[8];
+        uint32_t count;
+        uint32_t recordSize;
+        uint64_t heapOffset;
+        uint64_t heapSize;
+    };
+
+    static const char MAGIC[8];
+    csv::MappedFile file;
+    const Record* records;
+    const char* heap;
+    unsigned int count;
+    string text(Text ref) const;
+
+public:
+    BidSnapshot(string path);
+    unsigned int Size() const;
+    Bid GetBid(unsigned int index) const;
+    vector<Bid> ToVector() const;
+    static void Save(const vector<Bid>& bids, string path);
+    static int Convert(string csvPath, string snapshotPath);
+    static bool IsCurrent(string snapshotPath, string csvPath);
+};
+
+const char BidSnapshot::MAGIC[8] = {'B', 'I', 'D', 'S', 'N', 'A', 'P', '1'};
+
+/**
+ * Map a snapshot file and check that it is complete and that every
+ * string a record points to lies inside the heap
+ * @param path path to a file written by BidSnapshot::Save
+ */
+BidSnapshot::BidSnapshot(string path) : file(path) {
+    const Header* header = reinterpret_cast<const Header*>(file.data());
+
+    if (file.size() < sizeof(Header) || memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0
+            || header->recordSize != sizeof(Record)) {
+        throw runtime_error("BidSnapshot : " + path + " is not a bid snapshot");
+    }
+    if (sizeof(Header) + uint64_t(header->count) * sizeof(Record) > header->heapOffset
+            || header->heapOffset > file.size() || header->heapSize > file.size() - header->heapOffset) {
+        throw runtime_error("BidSnapshot : " + path + " is truncated");
+    }
+
+    count = header->count;
+    records = reinterpret_cast<const Record*>(file.data() + sizeof(Header));
+    heap = file.data() + header->heapOffset;
+
+    // checked once here so GetBid can copy text without checking each string
+    for (unsigned int i = 0; i < count; ++i) {
+        const Record& record = records[i];
+        for (Text ref : {record.title, record.fund, record.datePaid, record.receiptNumber}) {
+            if (uint64_t(ref.offset) + ref.length > header->heapSize) {
+                throw runtime_error("BidSnapshot : " + path + " has bid text outside its string heap");
+            }
+        }
+    }
+}
+
+/**
+ * Copy a string out of the heap
+ * @param ref offset and length of the string
+ */
+string BidSnapshot::text(Text ref) const {
+    return string(heap + ref.offset, ref.length);
+}
+
+/**
+ * Number of bids in the snapshot
+ */
+unsigned int BidSnapshot::Size() const {
+    return count;
+}
+
+/**
+ * Build a single bid straight from its record, without touching the rest
+ * @param index position of the bid in the snapshot
+ * @return the bid at that position
+ */
+Bid BidSnapshot::GetBid(unsigned int index) const {
+    const Record& record = records[index];
+    Bid bid;
+    bid.bidId = to_string(record.bidId);
+    bid.title = text(record.title);
+    bid.fund = text(record.fund);
+    bid.datePaid = text(record.datePaid);
+    bid.receiptNumber = text(record.receiptNumber);
+    bid.amount = record.amount;
+    bid.netSales = record.netSales;
+    return bid;
+}
+
+/**
+ * Build every bid in the snapshot
+ * @return a container holding all the bids in the snapshot
+ */
+vector<Bid> BidSnapshot::ToVector() const {
+    vector<Bid> bids;
+    bids.reserve(count);
+    for (unsigned int i = 0; i < count; ++i) {
+        bids.push_back(GetBid(i));
+    }
+    return bids;
+}
+
+/**
+ * Write a collection of bids to a snapshot file
+ * @param bids the bids to save, every bid id must be numeric
+ * @param path path of the snapshot to write
+ * @throws length_error if the bids or their text are too large for the format
+ */
+void BidSnapshot::Save(const vector<Bid>& bids, string path) {
+    vector<Record> records;
+    string heap;
+    map<string, Text> stored;
+
+    // place a string in the heap once, repeated strings share the same bytes
+    auto intern = [&](const string& value) {
+        auto found = stored.find(value);
+        if (found != stored.end()) {
+            return found->second;
+        }
+        if (heap.size() > UINT32_MAX || value.size() > UINT32_MAX) {
+            throw length_error("BidSnapshot : bid text does not fit in a snapshot");
+        }
+        Text ref = {uint32_t(heap.size()), uint32_t(value.size())};
+        heap += value;
+        stored[value] = ref;
+        return ref;
+    };
+
+    if (bids.size() > UINT32_MAX) {
+        throw length_error("BidSnapshot : too many bids for a snapshot");
+    }
+    records.reserve(bids.size());
+    for (const Bid& bid : bids) {
+        // an id with leading zeros would come back without them
+        unsigned long long id;
+        if (!parseUnsigned(bid.bidId, id) || id > UINT32_MAX || to_string(id) != bid.bidId) {
+            throw runtime_error("BidSnapshot : bid id " + bid.bidId + " is not numeric");
+        }
+
+        Record record = {};
+        record.bidId = uint32_t(id);
+        record.amount = bid.amount;
+        record.netSales = bid.netSales;
+        record.title = intern(bid.title);
+        record.fund = intern(bid.fund);
+        record.datePaid = intern(bid.datePaid);
+        record.receiptNumber = intern(bid.receiptNumber);
+        records.push_back(record);
+    }
+
+    Header header = {};
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.count = uint32_t(records.size());
+    header.recordSize = sizeof(Record);
+    header.heapOffset = sizeof(Header) + records.size() * sizeof(Record);
+    header.heapSize = heap.size();
+
+    // written beside the target and renamed over it once complete, so an
+    // interrupted save never leaves a partial snapshot that looks current
+    string temporary = path + ".tmp";
+    ofstream out(temporary, ios::out | ios::binary | ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(Record));
+    out.write(heap.data(), heap.size());
+    out.close();
+    if (!out || rename(temporary.c_str(), path.c_str()) != 0) {
+        remove(temporary.c_str());
+        throw runtime_error("BidSnapshot : failed to write " + path);
+    }
+}
+
+/**
+ * Convert a CSV file of bids to a snapshot
+ * @param csvPath the CSV to read
+ * @param snapshotPath the snapshot to write
+ * @return the number of bids converted
+ */
+int BidSnapshot::Convert(string csvPath, string snapshotPath) {
+    vector<Bid> bids = VectorSort::loadBids(csvPath);
+    Save(bids, snapshotPath);
+    return bids.size();
+}
+
+/**
+ * Check that a snapshot exists and was written after the CSV it came from
+ * @param snapshotPath the snapshot to check
+ * @param csvPath the CSV the snapshot was converted from
+ * @return true if the snapshot can be used in place of the CSV
+ */
+bool BidSnapshot::IsCurrent(string snapshotPath, string csvPath) {
+    struct stat snapshot, csv;
+    if (stat(snapshotPath.c_str(), &snapshot) != 0) {
+        return false;
+    }
+    if (stat(csvPath.c_str(), &csv) != 0) {
+        return true;
+    }
+    return snapshot.st_mtime >= csv.st_mtime;
+}
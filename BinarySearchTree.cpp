@@ -17,187 +17,323 @@ using namespace std;
 //============================================================================
 
 /**
- * Class containing data members and methods to
- * implement a binary search tree
+ * Class containing data members and methods to implement a binary search
+ * tree kept balanced as an AVL tree, so bids loaded in sorted order still
+ * give a tree of logarithmic height. Insert and Remove walk down the tree
+ * in a loop and remember the path, then rebalance back up along it. The
+ * nodes come from a NodePool and keep their bid as Record, Bid or
+ * CompactBid.
  */
-class BinarySearchTree {
+template <typename Record>
+class BinarySearchTreeOf {
 
 private:
     struct Node {
-        Bid bid;
+        Record bid;
         Node* left;
         Node* right;
+        int height;
         Node() {
             left = nullptr;
             right = nullptr;
+            height = 1;
         }
         Node(Bid abid) {
-            this->bid = abid;
+            this->bid = packBid<Record>(move(abid));
             this->left = nullptr;
             this->right = nullptr;
+            this->height = 1;
         }
     };
 
+    // an AVL tree of height 64 would need more nodes than memory can hold
+    static const int MAX_HEIGHT = 64;
     Node* root;
-    Node* tree;
-    void addNode(Node* node, Bid bid);
+    unsigned int count;
+    NodePool<Node> pool;
     void inOrder(Node* node);
-    Node* removeNode(Node* node, string bidId);
+    void clear();
+    Node* build(vector<Bid>& bids, const vector<size_t>& order, size_t first, size_t last);
+    static int height(Node* node);
+    static void updateHeight(Node* node);
+    static Node* rotateLeft(Node* node);
+    static Node* rotateRight(Node* node);
+    static Node* rebalance(Node* node);
 
 public:
-    BinarySearchTree();
-    virtual ~BinarySearchTree();
+    BinarySearchTreeOf();
+    virtual ~BinarySearchTreeOf();
     void InOrder();
     void Insert(Bid bid);
+    void BulkLoad(vector<Bid> bids);
     void Remove(string bidId);
     Bid Search(string bidId);
     bool Size();
-    static int loadBids(string, BinarySearchTree*);
+    unsigned int Count() const;
+    int Height() const;
+    static int loadBids(string, BinarySearchTreeOf*);
+    static int bulkLoadBids(string, BinarySearchTreeOf*);
 };
 
+using BinarySearchTree = BinarySearchTreeOf<Bid>;
+
 /**
  * Default constructor
  */
-BinarySearchTree::BinarySearchTree() {
+template <typename Record>
+BinarySearchTreeOf<Record>::BinarySearchTreeOf() {
     // initialize housekeeping variables
     root = nullptr;
+    count = 0;
 }
 
 /**
  * Destructor
  */
-BinarySearchTree::~BinarySearchTree() {
+template <typename Record>
+BinarySearchTreeOf<Record>::~BinarySearchTreeOf() {
+    clear();
+}
+
+/**
+ * Remove every bid from the tree
+ */
+template <typename Record>
+void BinarySearchTreeOf<Record>::clear() {
+    // free the nodes without recursion by rotating left children up
+    // until each node has none, then stepping right
+    while (root != nullptr) {
+        if (root->left != nullptr) {
+            Node* left = root->left;
+            root->left = left->right;
+            left->right = root;
+            root = left;
+        } else {
+            Node* right = root->right;
+            pool.Delete(root);
+            root = right;
+        }
+    }
+    count = 0;
+}
+
+/**
+ * Height of a subtree, 0 for an empty one
+ */
+template <typename Record>
+int BinarySearchTreeOf<Record>::height(Node* node) {
+    return node == nullptr ? 0 : node->height;
+}
+
+/**
+ * Recompute the height of a node from its children
+ */
+template <typename Record>
+void BinarySearchTreeOf<Record>::updateHeight(Node* node) {
+    node->height = 1 + max(height(node->left), height(node->right));
+}
 
+/**
+ * Rotate a subtree left, its right child becomes its root
+ * @param node root of the subtree
+ * @return the new root of the subtree
+ */
+template <typename Record>
+typename BinarySearchTreeOf<Record>::Node* BinarySearchTreeOf<Record>::rotateLeft(Node* node) {
+    Node* right = node->right;
+    node->right = right->left;
+    right->left = node;
+    updateHeight(node);
+    updateHeight(right);
+    return right;
+}
+
+/**
+ * Rotate a subtree right, its left child becomes its root
+ * @param node root of the subtree
+ * @return the new root of the subtree
+ */
+template <typename Record>
+typename BinarySearchTreeOf<Record>::Node* BinarySearchTreeOf<Record>::rotateRight(Node* node) {
+    Node* left = node->left;
+    node->left = left->right;
+    left->right = node;
+    updateHeight(node);
+    updateHeight(left);
+    return left;
+}
+
+/**
+ * Restore the AVL balance of a subtree whose children differ in height
+ * by at most two
+ * @param node root of the subtree
+ * @return the new root of the subtree
+ */
+template <typename Record>
+typename BinarySearchTreeOf<Record>::Node* BinarySearchTreeOf<Record>::rebalance(Node* node) {
+    updateHeight(node);
+    int balance = height(node->left) - height(node->right);
+    if (balance > 1) {
+        if (height(node->left->left) < height(node->left->right)) {
+            node->left = rotateLeft(node->left);
+        }
+        return rotateRight(node);
+    }
+    if (balance < -1) {
+        if (height(node->right->right) < height(node->right->left)) {
+            node->right = rotateRight(node->right);
+        }
+        return rotateLeft(node);
+    }
+    return node;
 }
 
 /**
  * Traverse the tree in order
  */
-void BinarySearchTree::InOrder() {
+template <typename Record>
+void BinarySearchTreeOf<Record>::InOrder() {
     cout << root << endl;
     inOrder(root);
 }
 /**
- * Insert a bid to the Binary Search Tree
+ * Insert a bid to the Binary Search Tree, bids with the same id
+ * as one already in the tree go to its right
  * @param bid the bid to be inserted
  */
-void BinarySearchTree::Insert(Bid bid) {
-    if (root == nullptr) {
-        root = new Node(bid);
+template <typename Record>
+void BinarySearchTreeOf<Record>::Insert(Bid bid) {
+    // links followed from the root down to where the bid goes
+    Node** path[MAX_HEIGHT];
+    int depth = 0;
+    Node** link = &root;
+    while (*link != nullptr) {
+        path[depth++] = link;
+        link = bid.bidId >= bidIdOf((*link)->bid) ? &(*link)->right : &(*link)->left;
     }
-    else {
-        addNode(root, bid);
+    *link = pool.New(move(bid));
+    count++;
+
+    // rebalance back up the path, stopping once a subtree keeps its height
+    while (depth > 0) {
+        Node** parent = path[--depth];
+        int before = (*parent)->height;
+        *parent = rebalance(*parent);
+        if ((*parent)->height == before) {
+            break;
+        }
     }
 }
 
 /**
- * Remove a bid from the Binary Search Tree
- * @param bidId the id of the bid to be removed
+ * Replace the contents of the tree with a set of bids, building it
+ * bottom up into a perfectly balanced tree in one pass instead of
+ * inserting the bids one at a time. Bids that are not already in
+ * order of id are sorted first.
+ * @param bids the bids to load
  */
-void BinarySearchTree::Remove(string bidId) {
-    Node *par, *cur, *suc;
-    par = root;
-    while (par != nullptr) {
-        // if current bid is bid we are searching for
-        if (par->bid.bidId == bidId) {
-            // if the bid has no child to the left or right delete the bid
-            if (!par->left && !par->right){
-                delete par;
-            }
-            // if the bid has a left child but no right child delete the bid
-            // and make the parent bid point to the left bid
-            else if (par->left && !par->right) {
-                cur = par->left;
-                delete par;
-            }
-            // if the bid has a right child but no left child delete the bid
-            // and make the parent bid point to the right child
-            else if (!par->left && par->right) {
-                cur = par->right;
-                delete par;
-            }
-            // if the bid has a right and left child restructure the branches so
-            // that they can still properly be searched
-            else {
-                suc = par->left;
-                while (suc->left) {
-                    suc = suc->left;
-                }
-                par->bid = suc->bid;
-                delete suc;
-                return;
-            }
-        }
-        // if bid id we are seaching for is greater than current go to right branch
-        else if (par->bid.bidId < bidId) {
-            par = par->right;
-        }
-        // if id we are searching for is less than the current bid id go to left branch
-        else {
-            par = par->left;
-        }
+template <typename Record>
+void BinarySearchTreeOf<Record>::BulkLoad(vector<Bid> bids) {
+    // sort positions rather than the bids themselves so no bid is moved
+    // more than once, stable so bids with the same id keep their order
+    vector<size_t> order(bids.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    auto byId = [&](size_t a, size_t b) { return bids[a].bidId < bids[b].bidId; };
+    if (!is_sorted(order.begin(), order.end(), byId)) {
+        stable_sort(order.begin(), order.end(), byId);
     }
+    clear();
+    root = build(bids, order, 0, bids.size());
+    count = bids.size();
 }
 
-
 /**
- * Search for a bid and return the bid
- * @param bidId the id of the bid we want to find
+ * (Recursive) Build a balanced subtree from sorted bids, the middle
+ * bid becomes the root and each half becomes one side
+ * @param bids the bids, moved into the nodes
+ * @param order positions of the bids in order of id
+ * @param first index in order of the first bid in the subtree
+ * @param last index in order just past the last bid in the subtree
+ * @return the root of the subtree
  */
-Bid BinarySearchTree::Search(string bidId) {
-    Bid bid;
-    Node *temp;
-    temp = root;
-    while (temp->bid.bidId != bid.bidId) {
-        if (temp->bid.bidId == bidId) {
-            bid = temp->bid;
-            return bid;
-        }
-        if (temp->bid.bidId > bidId) {
-            if (temp->left == nullptr) {
-                return bid;
-            }
-            else {
-                temp = temp->left;
-                continue;
-            }
-        }
-        else {
-            if (temp->right == nullptr) {
-                return bid;
-            }
-            else {
-                temp = temp->right;
-                continue;
-            }
-        }
+template <typename Record>
+typename BinarySearchTreeOf<Record>::Node* BinarySearchTreeOf<Record>::build(
+        vector<Bid>& bids, const vector<size_t>& order, size_t first, size_t last) {
+    if (first == last) {
+        return nullptr;
     }
-    return bid;
+    size_t middle = first + (last - first) / 2;
+    Node* node = pool.New();
+    node->bid = packBid<Record>(move(bids[order[middle]]));
+    node->left = build(bids, order, first, middle);
+    node->right = build(bids, order, middle + 1, last);
+    updateHeight(node);
+    return node;
 }
 
 /**
- * Add a bid to some node (recursive)
- *
- * @param node Current node in tree
- * @param bid Bid to be added
+ * Remove a bid from the Binary Search Tree
+ * @param bidId the id of the bid to be removed
  */
-void BinarySearchTree::addNode(Node* node, Bid bid) {
-    if (bid.bidId >= node->bid.bidId) {
-        if (node->right == nullptr) {
-            node->right = new Node(bid);
-        }
-        else {
-            addNode(node->right, bid);
-        }
+template <typename Record>
+void BinarySearchTreeOf<Record>::Remove(string bidId) {
+    Node** path[MAX_HEIGHT];
+    int depth = 0;
+    Node** link = &root;
+    while (*link != nullptr && bidIdOf((*link)->bid) != bidId) {
+        path[depth++] = link;
+        link = bidId > bidIdOf((*link)->bid) ? &(*link)->right : &(*link)->left;
     }
-    else {
-        if (node->left == nullptr) {
-            node->left = new Node(bid);
+    // the bid is not in the tree
+    if (*link == nullptr) {
+        return;
+    }
+
+    Node* node = *link;
+    if (node->left != nullptr && node->right != nullptr) {
+        // with two children, take the bid of the smallest node on the
+        // right and remove that node instead
+        path[depth++] = link;
+        Node** successor = &node->right;
+        while ((*successor)->left != nullptr) {
+            path[depth++] = successor;
+            successor = &(*successor)->left;
         }
-        else {
-            addNode(node->left, bid);
+        node->bid = move((*successor)->bid);
+        link = successor;
+        node = *successor;
+    }
+
+    // the node now has at most one child, which takes its place
+    *link = node->left != nullptr ? node->left : node->right;
+    pool.Delete(node);
+    count--;
+
+    while (depth > 0) {
+        Node** parent = path[--depth];
+        *parent = rebalance(*parent);
+    }
+}
+
+
+/**
+ * Search for a bid and return the bid
+ * @param bidId the id of the bid we want to find
+ * @return the bid, or an empty bid if it is not found
+ */
+template <typename Record>
+Bid BinarySearchTreeOf<Record>::Search(string bidId) {
+    Node* node = root;
+    while (node != nullptr) {
+        const auto& id = bidIdOf(node->bid);
+        if (id == bidId) {
+            return toBid(node->bid);
         }
+        node = bidId > id ? node->right : node->left;
     }
+    return Bid();
 }
 
 /**
@@ -205,10 +341,12 @@ void BinarySearchTree::addNode(Node* node, Bid bid) {
  * binary search tree by doing an in order traversal
  * @param node current node in the tree
  */
-void BinarySearchTree::inOrder(Node* node) {
+template <typename Record>
+void BinarySearchTreeOf<Record>::inOrder(Node* node) {
     if (!node) return;
     inOrder(node->left);
-    cout << node->bid.bidId << ": " << node->bid.title << " | " << node->bid.amount << " | " << node->bid.fund << endl;
+    const Bid& bid = toBid(node->bid);
+    cout << bid.bidId << ": " << bid.title << " | " << bid.amount << " | " << bid.fund << endl;
     inOrder(node->right);
 }
 
@@ -218,31 +356,33 @@ void BinarySearchTree::inOrder(Node* node) {
  * @param bst the binary search tree that the bids will be put in
  * @return the number of bids added to the tree
  */
-int BinarySearchTree::loadBids(string csvPath, BinarySearchTree* bst) {
+template <typename Record>
+int BinarySearchTreeOf<Record>::loadBids(string csvPath, BinarySearchTreeOf* bst) {
     int numBids = 0;
 
-    // initialize the CSV Parser using the given path
-    csv::Parser file = csv::Parser(csvPath);
+    // initialize the CSV Reader, rows are parsed one at a time as they are loaded
+    // and only the bid columns are kept
+    csv::Reader file = csv::Reader(csvPath, csv::eMMAP, ',', BID_COLUMNS);
 
     try {
         // loop to read rows of a CSV file
-        for (unsigned int i = 0; i < file.rowCount(); i++) {
+        while (file.next()) {
 
             // Create a data structure and add to the collection of bids
             Bid bid;
-            bid.bidId = file[i][1];
-            bid.title = file[i][0];
-            bid.fund = file[i][19];
-            bid.datePaid = file[i][10];
-            bid.receiptNumber = file[i][15];
-            bid.netSales = strToDouble(file[i][18],'$');
-            bid.amount = strToDouble(file[i][4], '$');
+            bid.bidId = string(file[BID_ID]);
+            bid.title = string(file[TITLE]);
+            bid.fund = string(file[FUND]);
+            bid.datePaid = string(file[DATE_PAID]);
+            bid.receiptNumber = string(file[RECEIPT_NUMBER]);
+            bid.netSales = currencyToDouble(file[NET_SALES]);
+            bid.amount = currencyToDouble(file[AMOUNT]);
 
             //cout << "Item: " << bid.bidId << ":" << bid.title << ", Fund: " << bid.fund << ", Amount: " << bid.amount << endl;
 
             numBids++;
             // push this bid to the end
-            bst->Insert(bid);
+            bst->Insert(move(bid));
         }
     } catch (csv::Error &e) {
         cerr << e.what() << endl;
@@ -250,11 +390,30 @@ int BinarySearchTree::loadBids(string csvPath, BinarySearchTree* bst) {
     return numBids;
 }
 
+/**
+ * Load a CSV file containing bids and build the tree from them in one
+ * pass with BulkLoad, replacing what it held. Faster than loadBids, but
+ * every bid is held in memory until the file has been read, where
+ * loadBids only ever holds one row.
+ *
+ * @param csvPath the path to the CSV file to load
+ * @param bst the tree to build
+ * @return the number of bids read
+ */
+template <typename Record>
+int BinarySearchTreeOf<Record>::bulkLoadBids(string csvPath, BinarySearchTreeOf* bst) {
+    vector<Bid> bids = VectorSort::loadBids(csvPath);
+    int numBids = bids.size();
+    bst->BulkLoad(move(bids));
+    return numBids;
+}
+
 /**
  * Method to check if the Binary Search Tree has been filled with bids yet
  * @return true if the tree is empty false if the bids have been loaded
  */
-bool BinarySearchTree::Size(){
+template <typename Record>
+bool BinarySearchTreeOf<Record>::Size(){
     if (root == nullptr){
         return true;
     }
@@ -263,3 +422,19 @@ bool BinarySearchTree::Size(){
     }
 }
 
+
+/**
+ * Number of bids in the tree
+ */
+template <typename Record>
+unsigned int BinarySearchTreeOf<Record>::Count() const {
+    return count;
+}
+
+/**
+ * Number of levels in the tree, 0 when it is empty
+ */
+template <typename Record>
+int BinarySearchTreeOf<Record>::Height() const {
+    return height(root);
+}
@@ -27,12 +27,231 @@
 #include <fstream>
 #include <sstream>
 #include <iomanip>
+#include <cstring>
+#include <exception>
+#include <thread>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "CSVparser.hpp"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# include <immintrin.h>
+# define CSV_X86_SIMD
+#endif
+
 namespace csv {
 
-  Parser::Parser(const std::string &data, const DataType &type, char sep)
-    : _type(type), _sep(sep)
+  namespace
+  {
+      /*
+      ** Tokenizer kernels: each calls emit(p) for every separator in
+      ** [begin, end) that is not between double quotes.
+      */
+      template<typename Emit>
+      void scanScalar(const char *begin, const char *end, char sep, Emit emit)
+      {
+          bool quoted = false;
+
+          for (const char *p = begin; p != end; p++)
+          {
+              if (*p == '"')
+                  quoted = ((quoted) ? (false) : (true));
+              else if (*p == sep && !quoted)
+                  emit(p);
+          }
+      }
+
+#ifdef CSV_X86_SIMD
+      // Bit i of the result is set when an odd number of quotes sit at or
+      // before bit i, i.e. when byte i is inside a quoted run
+      inline uint32_t prefixXor(uint32_t mask)
+      {
+          mask ^= mask << 1;
+          mask ^= mask << 2;
+          mask ^= mask << 4;
+          mask ^= mask << 8;
+          mask ^= mask << 16;
+          return mask;
+      }
+
+      // Emits the separators of one block given its quote and separator
+      // bitmasks, carrying the quote state over to the next block
+      template<unsigned int Width, typename Emit>
+      inline void emitBlock(const char *block, uint32_t quotes, uint32_t seps,
+                            uint32_t &inside, Emit &emit)
+      {
+          uint32_t quoted = prefixXor(quotes) ^ inside;
+          inside = 0u - ((quoted >> (Width - 1)) & 1u);
+
+          seps &= ~quoted;
+          while (seps)
+          {
+              emit(block + __builtin_ctz(seps));
+              seps &= seps - 1;
+          }
+      }
+
+      // Finishes the bytes after the last whole block from the carried state
+      template<typename Emit>
+      inline void scanTail(const char *p, const char *end, char sep, uint32_t inside, Emit &emit)
+      {
+          bool quoted = inside != 0;
+          for (; p != end; p++)
+          {
+              if (*p == '"')
+                  quoted = ((quoted) ? (false) : (true));
+              else if (*p == sep && !quoted)
+                  emit(p);
+          }
+      }
+
+      template<typename Emit>
+      void scanSSE2(const char *begin, const char *end, char sep, Emit emit)
+      {
+          uint32_t inside = 0;
+          const __m128i quote = _mm_set1_epi8('"');
+          const __m128i separator = _mm_set1_epi8(sep);
+          const char *p = begin;
+
+          for (; end - p >= 16; p += 16)
+          {
+              __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+              uint32_t quotes = _mm_movemask_epi8(_mm_cmpeq_epi8(block, quote));
+              uint32_t seps = _mm_movemask_epi8(_mm_cmpeq_epi8(block, separator));
+              if (quotes | seps)
+                  emitBlock<16>(p, quotes, seps, inside, emit);
+          }
+
+          scanTail(p, end, sep, inside, emit);
+      }
+
+      template<typename Emit>
+      __attribute__((target("avx2")))
+      void scanAVX2(const char *begin, const char *end, char sep, Emit emit)
+      {
+          const __m256i quote = _mm256_set1_epi8('"');
+          const __m256i separator = _mm256_set1_epi8(sep);
+          uint32_t inside = 0;
+          const char *p = begin;
+
+          for (; end - p >= 32; p += 32)
+          {
+              __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+              uint32_t quotes = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, quote));
+              uint32_t seps = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, separator));
+              if (quotes | seps)
+                  emitBlock<32>(p, quotes, seps, inside, emit);
+          }
+
+          scanTail(p, end, sep, inside, emit);
+      }
+
+      const bool hasAVX2 = __builtin_cpu_supports("avx2");
+#endif
+
+      template<typename Emit>
+      void scan(const char *begin, const char *end, char sep, Kernel kernel, Emit emit)
+      {
+#ifdef CSV_X86_SIMD
+          if (kernel == eSIMD)
+          {
+              if (hasAVX2)
+                  scanAVX2(begin, end, sep, emit);
+              else
+                  scanSSE2(begin, end, sep, emit);
+              return;
+          }
+#endif
+          scanScalar(begin, end, sep, emit);
+      }
+
+      // Slices one line into fields, separators inside quotes are kept.
+      // With slots, only the projected fields are stored, each at its slot
+      // past the current end. Returns how many fields the line holds.
+      std::size_t splitLine(const char *begin, const char *end, char sep,
+                            const std::vector<int> &slots,
+                            std::vector<std::string_view> &fields)
+      {
+          const char *tokenStart = begin;
+          std::size_t count = 0;
+          std::size_t base = fields.size();
+
+          if (!slots.empty())
+          {
+              std::size_t kept = 0;
+              for (std::size_t i = 0; i < slots.size(); i++)
+                  kept += slots[i] >= 0;
+              fields.resize(base + kept);
+          }
+
+          auto store = [&](const char *tokenEnd)
+          {
+              std::string_view field(tokenStart, tokenEnd - tokenStart);
+              if (slots.empty())
+                  fields.push_back(field);
+              else if (count < slots.size() && slots[count] >= 0)
+                  fields[base + slots[count]] = field;
+              count++;
+          };
+
+          scan(begin, end, sep, eSIMD, [&](const char *p)
+          {
+              store(p);
+              tokenStart = p + 1;
+          });
+
+          //end
+          store(end);
+          return count;
+      }
+
+      // Returns the end of the line starting at cur and moves cur past it
+      const char *lineEnd(const char *&cur, const char *end)
+      {
+          const char *eol = static_cast<const char *>(std::memchr(cur, '\n', end - cur));
+          if (!eol)
+          {
+              cur = end;
+              return end;
+          }
+          cur = eol + 1;
+          return eol;
+      }
+
+      // Splits every line of [begin, end) into fields, checking each row
+      void splitRange(const char *begin, const char *end, char sep, std::size_t columns,
+                      const std::vector<int> &slots, std::vector<std::string_view> &fields)
+      {
+          while (begin != end)
+          {
+              const char *line = begin;
+              const char *eol = lineEnd(begin, end);
+
+              if (eol == line)
+                  continue;
+
+              // if value(s) missing
+              if (splitLine(line, eol, sep, slots, fields) != columns)
+                throw Error("corrupted data !");
+          }
+      }
+
+      void splitHeader(const std::string &line, char sep, std::vector<std::string> &header)
+      {
+          std::stringstream ss(line);
+          std::string item;
+
+          while (std::getline(ss, item, sep))
+              header.push_back(item);
+      }
+  }
+
+  Parser::Parser(const std::string &data, const DataType &type, char sep, unsigned int threads,
+                 const Projection &projection)
+    : _type(type), _sep(sep), _projection(projection), _columns(0)
   {
       std::string line;
       if (type == eFILE)
@@ -58,6 +277,12 @@ namespace csv {
         else
             throw Error(std::string("Failed to open ").append(_file));
       }
+      else if (type == eMMAP)
+      {
+        _file = data;
+        _mapping.reset(new MappedFile(_file));
+        parseMapped(threads);
+      }
       else
       {
         std::istringstream stream(data);
@@ -82,11 +307,13 @@ namespace csv {
 
   void Parser::parseHeader(void)
   {
-      std::stringstream ss(_originalFile[0]);
-      std::string item;
+      std::vector<std::string> header;
 
-      while (std::getline(ss, item, _sep))
-          _header.push_back(item);
+      splitHeader(_originalFile[0], _sep, header);
+      _columns = header.size();
+      _slots = _projection.resolve(header);
+      _header = _projection.apply(header, _slots);
+      _schema = std::make_shared<const Schema>(_header);
   }
 
   void Parser::parseContent(void)
@@ -96,35 +323,102 @@ namespace csv {
      it = _originalFile.begin();
      it++; // skip header
 
+     std::vector<std::string_view> fields;
+
      for (; it != _originalFile.end(); it++)
      {
-         bool quoted = false;
-         int tokenStart = 0;
-         unsigned int i = 0;
+         fields.clear();
+         std::size_t count = splitLine(it->data(), it->data() + it->length(), _sep, _slots, fields);
 
-         Row *row = new Row(_header);
-
-         for (; i != it->length(); i++)
-         {
-              if (it->at(i) == '"')
-                  quoted = ((quoted) ? (false) : (true));
-              else if (it->at(i) == ',' && !quoted)
-              {
-                  row->push(it->substr(tokenStart, i - tokenStart));
-                  tokenStart = i + 1;
-              }
-         }
-
-         //end
-         row->push(it->substr(tokenStart, it->length() - tokenStart));
+         Row *row = new Row(_schema);
+         for (std::size_t i = 0; i != fields.size(); i++)
+             row->push(std::string(fields[i]));
 
          // if value(s) missing
-         if (row->size() != _header.size())
+         if (count != _columns)
           throw Error("corrupted data !");
          _content.push_back(row);
      }
   }
 
+  void Parser::parseMapped(unsigned int threads)
+  {
+      const char *cur = _mapping->data();
+      const char *end = cur + _mapping->size();
+
+      // header is parsed once through the regular path
+      while (cur != end && _originalFile.empty())
+      {
+          const char *begin = cur;
+          const char *eol = lineEnd(cur, end);
+          if (eol != begin)
+          {
+              _originalFile.push_back(std::string(begin, eol - begin));
+              parseHeader();
+          }
+      }
+
+      if (_originalFile.size() == 0)
+        throw Error(std::string("No Data in ").append(_file));
+
+      // not worth starting threads for less than a few pages each
+      if (threads > static_cast<std::size_t>(end - cur) / 65536 + 1)
+          threads = (end - cur) / 65536 + 1;
+      if (threads <= 1)
+      {
+          splitRange(cur, end, _sep, _columns, _slots, _views);
+          return;
+      }
+
+      // Cut the body into one byte range per thread. A newline always
+      // ends a record here (a quote never carries over to the next line,
+      // as with getline in eFILE mode), so moving each seam just past the
+      // next newline puts it back in the unquoted state and every chunk
+      // can be parsed on its own.
+      std::vector<const char *> seams(1, cur);
+      for (unsigned int t = 1; t < threads; t++)
+      {
+          const char *seam = cur + (end - cur) / threads * t;
+          if (seam < seams.back())
+              seam = seams.back();
+          if (seam != end && seam[-1] != '\n')
+              lineEnd(seam, end);
+          seams.push_back(seam);
+      }
+      seams.push_back(end);
+
+      std::vector<std::vector<std::string_view> > chunks(threads);
+      std::vector<std::exception_ptr> errors(threads);
+      std::vector<std::thread> workers;
+
+      for (unsigned int t = 0; t < threads; t++)
+          workers.push_back(std::thread([&, t]()
+          {
+              try
+              {
+                  splitRange(seams[t], seams[t + 1], _sep, _columns, _slots, chunks[t]);
+              }
+              catch (...)
+              {
+                  errors[t] = std::current_exception();
+              }
+          }));
+
+      for (unsigned int t = 0; t < threads; t++)
+          workers[t].join();
+      for (unsigned int t = 0; t < threads; t++)
+          if (errors[t])
+              std::rethrow_exception(errors[t]);
+
+      // merge the rows back in file order
+      std::size_t total = 0;
+      for (unsigned int t = 0; t < threads; t++)
+          total += chunks[t].size();
+      _views.reserve(total);
+      for (unsigned int t = 0; t < threads; t++)
+          _views.insert(_views.end(), chunks[t].begin(), chunks[t].end());
+  }
+
   Row &Parser::getRow(unsigned int rowPosition) const
   {
       if (rowPosition < _content.size())
@@ -139,6 +433,8 @@ namespace csv {
 
   unsigned int Parser::rowCount(void) const
   {
+      if (_type == eMMAP)
+          return _views.size() / _header.size();
       return _content.size();
   }
 
@@ -159,8 +455,19 @@ namespace csv {
       return _header[pos];
   }
 
+  std::string_view Parser::getView(unsigned int row, unsigned int col) const
+  {
+      if (_type != eMMAP)
+          throw Error("views are only available in eMMAP mode");
+      if (col >= _header.size() || row >= rowCount())
+          throw Error("can't return this value (doesn't exist)");
+      return _views[row * _header.size() + col];
+  }
+
   bool Parser::deleteRow(unsigned int pos)
   {
+    if (_type == eMMAP)
+      return false;
     if (pos < _content.size())
     {
       delete *(_content.begin() + pos);
@@ -172,7 +479,10 @@ namespace csv {
 
   bool Parser::addRow(unsigned int pos, const std::vector<std::string> &r)
   {
-    Row *row = new Row(_header);
+    if (_type == eMMAP)
+      return false;
+
+    Row *row = new Row(_schema);
 
     for (auto it = r.begin(); it != r.end(); it++)
       row->push(*it);
@@ -187,7 +497,9 @@ namespace csv {
 
   void Parser::sync(void) const
   {
-    if (_type == DataType::eFILE)
+    // a projected parser only holds some of the columns, writing it back
+    // would drop the others from the file
+    if (_type == DataType::eFILE && _projection.empty())
     {
       std::ofstream f;
       f.open(_file, std::ios::out | std::ios::trunc);
@@ -215,12 +527,315 @@ namespace csv {
       return _file;
   }
 
+  /*
+  ** TOKENIZER
+  */
+
+  unsigned int countFields(const char *line, std::size_t length, char sep, Kernel kernel)
+  {
+      unsigned int fields = 1;
+
+      scan(line, line + length, sep, kernel, [&](const char *)
+      {
+          fields++;
+      });
+      return fields;
+  }
+
+  const char *kernelName(Kernel kernel)
+  {
+#ifdef CSV_X86_SIMD
+      if (kernel == eSIMD)
+          return (hasAVX2) ? ("AVX2") : ("SSE2");
+#endif
+      (void)kernel;
+      return "scalar";
+  }
+
+  /*
+  ** PROJECTION
+  */
+
+  namespace
+  {
+      std::string trim(const std::string &name)
+      {
+          std::size_t first = name.find_first_not_of(" \t\r");
+          if (first == std::string::npos)
+              return "";
+          return name.substr(first, name.find_last_not_of(" \t\r") - first + 1);
+      }
+  }
+
+  Projection::Projection(void) {}
+
+  Projection::Projection(const std::vector<unsigned int> &positions)
+      : _positions(positions) {}
+
+  Projection::Projection(const std::vector<std::string> &names)
+      : _names(names) {}
+
+  bool Projection::empty(void) const
+  {
+      return _positions.empty() && _names.empty();
+  }
+
+  unsigned int Projection::size(void) const
+  {
+      return _positions.size() + _names.size();
+  }
+
+  std::vector<int> Projection::resolve(const std::vector<std::string> &header) const
+  {
+      std::vector<int> slots;
+
+      if (empty())
+          return slots;
+      slots.assign(header.size(), -1);
+
+      for (std::size_t slot = 0; slot != _positions.size(); slot++)
+      {
+          if (_positions[slot] >= header.size())
+              throw Error("can't project this column (doesn't exist)");
+          if (slots[_positions[slot]] >= 0)
+              throw Error("column projected twice");
+          slots[_positions[slot]] = slot;
+      }
+
+      for (std::size_t slot = 0; slot != _names.size(); slot++)
+      {
+          std::string name = trim(_names[slot]);
+          std::size_t pos = 0;
+
+          while (pos != header.size() && trim(header[pos]) != name)
+              pos++;
+          if (pos == header.size())
+              throw Error(std::string("can't project column ").append(_names[slot]).append(" (doesn't exist)"));
+          if (slots[pos] >= 0)
+              throw Error("column projected twice");
+          slots[pos] = slot;
+      }
+      return slots;
+  }
+
+  std::vector<std::string> Projection::apply(const std::vector<std::string> &header,
+                                             const std::vector<int> &slots) const
+  {
+      if (slots.empty())
+          return header;
+
+      std::vector<std::string> projected(size());
+      for (std::size_t pos = 0; pos != slots.size(); pos++)
+          if (slots[pos] >= 0)
+              projected[slots[pos]] = header[pos];
+      return projected;
+  }
+
+  /*
+  ** MAPPEDFILE
+  */
+
+  MappedFile::MappedFile(const std::string &file)
+      : _data(nullptr), _size(0), _released(0)
+  {
+      int fd = ::open(file.c_str(), O_RDONLY);
+      if (fd < 0)
+          throw Error(std::string("Failed to open ").append(file));
+
+      struct stat st;
+      if (::fstat(fd, &st) != 0)
+      {
+          ::close(fd);
+          throw Error(std::string("Failed to stat ").append(file));
+      }
+
+      _size = st.st_size;
+      if (_size > 0)
+      {
+          void *addr = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+          if (addr == MAP_FAILED)
+          {
+              ::close(fd);
+              throw Error(std::string("Failed to map ").append(file));
+          }
+          ::madvise(addr, _size, MADV_SEQUENTIAL);
+          _data = static_cast<const char *>(addr);
+      }
+      ::close(fd);
+  }
+
+  MappedFile::~MappedFile(void)
+  {
+      if (_data)
+          ::munmap(const_cast<char *>(_data), _size);
+  }
+
+  const char *MappedFile::data(void) const
+  {
+      return _data;
+  }
+
+  std::size_t MappedFile::size(void) const
+  {
+      return _size;
+  }
+
+  // Hands every whole page below upTo back to the kernel
+  void MappedFile::release(std::size_t upTo)
+  {
+      static const std::size_t page = ::sysconf(_SC_PAGESIZE);
+
+      upTo -= upTo % page;
+      if (upTo > _released)
+      {
+          ::madvise(const_cast<char *>(_data) + _released, upTo - _released, MADV_DONTNEED);
+          _released = upTo;
+      }
+  }
+
+  /*
+  ** READER
+  */
+
+  Reader::Reader(const std::string &data, const DataType &type, char sep,
+                 const Projection &projection)
+    : _sep(sep), _rowNumber(0), _columns(0)
+  {
+      if (type == ePURE)
+      {
+          _pure = data;
+          _begin = _pure.data();
+          _end = _begin + _pure.size();
+      }
+      else
+      {
+          _mapping.reset(new MappedFile(data));
+          _begin = _mapping->data();
+          _end = _begin + _mapping->size();
+      }
+      _cur = _begin;
+      _released = _begin;
+
+      const char *eol;
+      const char *line = nextLine(eol);
+      if (!line)
+      {
+          if (type == ePURE)
+            throw Error(std::string("No Data in pure content"));
+          throw Error(std::string("No Data in ").append(data));
+      }
+      std::vector<std::string> header;
+      splitHeader(std::string(line, eol - line), _sep, header);
+      _columns = header.size();
+      _slots = projection.resolve(header);
+      _header = projection.apply(header, _slots);
+  }
+
+  Reader::~Reader(void) {}
+
+  // Returns the next non-empty line, or nullptr at the end of the input
+  const char *Reader::nextLine(const char *&eol)
+  {
+      while (_cur != _end)
+      {
+          const char *line = _cur;
+          eol = lineEnd(_cur, _end);
+          if (eol != line)
+              return line;
+      }
+      return nullptr;
+  }
+
+  bool Reader::next(void)
+  {
+      // pages behind the previous record are no longer referenced
+      if (_mapping && _cur - _released >= (1 << 20))
+      {
+          _mapping->release(_cur - _begin);
+          _released = _cur;
+      }
+
+      const char *eol;
+      const char *line = nextLine(eol);
+      if (!line)
+          return false;
+
+      _fields.clear();
+
+      // if value(s) missing
+      if (splitLine(line, eol, _sep, _slots, _fields) != _columns)
+        throw Error("corrupted data !");
+      _rowNumber++;
+      return true;
+  }
+
+  unsigned int Reader::size(void) const
+  {
+      return _fields.size();
+  }
+
+  unsigned int Reader::columnCount(void) const
+  {
+      return _header.size();
+  }
+
+  unsigned int Reader::rowNumber(void) const
+  {
+      return _rowNumber;
+  }
+
+  const std::vector<std::string> &Reader::getHeader(void) const
+  {
+      return _header;
+  }
+
+  std::string_view Reader::operator[](unsigned int valuePosition) const
+  {
+      if (valuePosition < _fields.size())
+          return _fields[valuePosition];
+      throw Error("can't return this value (doesn't exist)");
+  }
+
+  /*
+  ** SCHEMA
+  */
+
+  Schema::Schema(const std::vector<std::string> &names)
+      : _names(names)
+  {
+      // the first of two identical names wins, as with the old linear scan
+      for (unsigned int i = 0; i != _names.size(); i++)
+          _index.emplace(_names[i], i);
+  }
+
+  const std::vector<std::string> &Schema::names(void) const
+  {
+      return _names;
+  }
+
+  unsigned int Schema::size(void) const
+  {
+      return _names.size();
+  }
+
+  int Schema::find(const std::string &name) const
+  {
+      std::unordered_map<std::string, unsigned int>::const_iterator it = _index.find(name);
+
+      if (it == _index.end())
+          return -1;
+      return it->second;
+  }
+
   /*
   ** ROW
   */
 
+  Row::Row(const std::shared_ptr<const Schema> &schema)
+      : _schema(schema) {}
+
   Row::Row(const std::vector<std::string> &header)
-      : _header(header) {}
+      : _schema(std::make_shared<const Schema>(header)) {}
 
   Row::~Row(void) {}
 
@@ -236,19 +851,12 @@ namespace csv {
 
   bool Row::set(const std::string &key, const std::string &value)
   {
-    std::vector<std::string>::const_iterator it;
-    int pos = 0;
+    int pos = _schema->find(key);
 
-    for (it = _header.begin(); it != _header.end(); it++)
-    {
-        if (key == *it)
-        {
-          _values[pos] = value;
-          return true;
-        }
-        pos++;
-    }
-    return false;
+    if (pos < 0 || static_cast<unsigned int>(pos) >= _values.size())
+      return false;
+    _values[pos] = value;
+    return true;
   }
 
   const std::string Row::operator[](unsigned int valuePosition) const
@@ -260,16 +868,10 @@ namespace csv {
 
   const std::string Row::operator[](const std::string &key) const
   {
-      std::vector<std::string>::const_iterator it;
-      int pos = 0;
-
-      for (it = _header.begin(); it != _header.end(); it++)
-      {
-          if (key == *it)
-              return _values[pos];
-          pos++;
-      }
+      int pos = _schema->find(key);
 
+      if (pos >= 0 && static_cast<unsigned int>(pos) < _values.size())
+          return _values[pos];
       throw Error("can't return this value (doesn't exist)");
   }
 
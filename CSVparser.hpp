@@ -28,10 +28,16 @@
 # define    _CSVPARSER_HPP_
 
 # include <stdexcept>
+# include <cctype>
 # include <string>
 # include <vector>
 # include <list>
 # include <sstream>
+# include <memory>
+# include <string_view>
+# include <unordered_map>
+# include <charconv>
+# include <type_traits>
 
 namespace csv
 {
@@ -45,9 +51,38 @@ namespace csv
         }
     };
 
+    /*
+    ** Column names shared by every Row of a parser, with a hashed
+    ** name -> position index. Immutable once built.
+    */
+    class Schema
+    {
+      public:
+        Schema(const std::vector<std::string> &);
+
+      public:
+        const std::vector<std::string> &names(void) const;
+        unsigned int size(void) const;
+        int find(const std::string &) const;
+
+      private:
+        const std::vector<std::string> _names;
+        std::unordered_map<std::string, unsigned int> _index;
+    };
+
+    // Types Row::getValue converts with std::from_chars
+    template<typename T>
+    struct isNumber : std::integral_constant<bool,
+        (std::is_integral<T>::value || std::is_floating_point<T>::value)
+        && !std::is_same<T, bool>::value && !std::is_same<T, char>::value
+        && !std::is_same<T, signed char>::value && !std::is_same<T, unsigned char>::value>
+    {
+    };
+
     class Row
     {
     	public:
+    	    Row(const std::shared_ptr<const Schema> &);
     	    Row(const std::vector<std::string> &);
     	    ~Row(void);
 
@@ -57,7 +92,7 @@ namespace csv
             bool set(const std::string &, const std::string &);
 
     	private:
-    		const std::vector<std::string> _header;
+    		const std::shared_ptr<const Schema> _schema;
     		std::vector<std::string> _values;
 
         public:
@@ -67,10 +102,25 @@ namespace csv
             {
                 if (pos < _values.size())
                 {
-                    T res;
-                    std::stringstream ss;
-                    ss << _values[pos];
-                    ss >> res;
+                    T res = T();
+                    if constexpr (isNumber<T>::value)
+                    {
+                        // same result as the stream for numbers, without
+                        // building a stringstream for every conversion
+                        const char *first = _values[pos].data();
+                        const char *last = first + _values[pos].size();
+                        while (first != last && std::isspace(static_cast<unsigned char>(*first)))
+                            first++;
+                        if (first != last && *first == '+')
+                            first++;
+                        std::from_chars(first, last, res);
+                    }
+                    else
+                    {
+                        std::stringstream ss;
+                        ss << _values[pos];
+                        ss >> res;
+                    }
                     return res;
                 }
                 throw Error("can't return this value (doesn't exist)");
@@ -83,15 +133,86 @@ namespace csv
 
     enum DataType {
         eFILE = 0,
-        ePURE = 1
+        ePURE = 1,
+        eMMAP = 2
+    };
+
+    /*
+    ** Columns a parser should keep, listed by position or by header name
+    ** (names match ignoring surrounding spaces). Kept columns are numbered
+    ** 0..size()-1 in the order listed; the others are never stored.
+    */
+    class Projection
+    {
+      public:
+        Projection(void);
+        Projection(const std::vector<unsigned int> &);
+        Projection(const std::vector<std::string> &);
+
+      public:
+        bool empty(void) const;
+        unsigned int size(void) const;
+        std::vector<int> resolve(const std::vector<std::string> &) const;
+        std::vector<std::string> apply(const std::vector<std::string> &,
+                                       const std::vector<int> &) const;
+
+      private:
+        std::vector<unsigned int> _positions;
+        std::vector<std::string> _names;
+    };
+
+    enum Kernel {
+        eSCALAR = 0,
+        eSIMD = 1
+    };
+
+    /*
+    ** Tokenizer shared by every parse mode. A field ends at each `sep`
+    ** that is not between double quotes. eSIMD compares 32 (AVX2) or 16
+    ** (SSE2) bytes per step and turns the quote bitmask into an in-quote
+    ** mask with a prefix xor; it is eSCALAR on other targets.
+    */
+    unsigned int countFields(const char *line, std::size_t length, char sep, Kernel kernel = eSIMD);
+    const char *kernelName(Kernel kernel);
+
+    /*
+    ** Read-only mapping of a whole file. Parser keeps one alive in eMMAP
+    ** mode so the field views it hands out stay valid.
+    */
+    class MappedFile
+    {
+      public:
+        MappedFile(const std::string &);
+        ~MappedFile(void);
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+      public:
+        const char *data(void) const;
+        std::size_t size(void) const;
+        void release(std::size_t upTo);
+
+      private:
+        const char *_data;
+        std::size_t _size;
+        std::size_t _released;
     };
 
+    /*
+    ** In eMMAP mode the body can be split into byte ranges parsed by
+    ** `threads` workers; the rows are merged back in file order. With a
+    ** projection only the projected columns are kept, and sync() is a
+    ** no-op so the file can't lose the others.
+    */
     class Parser
     {
 
     public:
-        Parser(const std::string &, const DataType &type = eFILE, char sep = ',');
+        Parser(const std::string &, const DataType &type = eFILE, char sep = ',', unsigned int threads = 1,
+               const Projection &projection = Projection());
         ~Parser(void);
+        Parser(const Parser &) = delete;
+        Parser &operator=(const Parser &) = delete;
 
     public:
         Row &getRow(unsigned int row) const;
@@ -100,6 +221,7 @@ namespace csv
         std::vector<std::string> getHeader(void) const;
         const std::string getHeaderElement(unsigned int pos) const;
         const std::string &getFileName(void) const;
+        std::string_view getView(unsigned int row, unsigned int col) const;
 
     public:
         bool deleteRow(unsigned int row);
@@ -109,18 +231,82 @@ namespace csv
     protected:
     	void parseHeader(void);
     	void parseContent(void);
+    	void parseMapped(unsigned int threads);
 
     private:
         std::string _file;
         const DataType _type;
         const char _sep;
+        const Projection _projection;
+        std::vector<int> _slots;
+        std::size_t _columns;
         std::vector<std::string> _originalFile;
         std::vector<std::string> _header;
+        std::shared_ptr<const Schema> _schema;
         std::vector<Row *> _content;
+        // eMMAP only: rowCount() * columnCount() slices into _mapping
+        std::unique_ptr<MappedFile> _mapping;
+        std::vector<std::string_view> _views;
 
     public:
         Row &operator[](unsigned int row) const;
     };
+
+    /*
+    ** Streaming reader: parses one record per next() into a reused field
+    ** buffer and drops the pages it has already walked past, so memory
+    ** stays flat whatever the size of the input. Views returned by
+    ** operator[] are only valid until the following call to next().
+    */
+    class Reader
+    {
+
+    public:
+        Reader(const std::string &, const DataType &type = eMMAP, char sep = ',',
+               const Projection &projection = Projection());
+        ~Reader(void);
+        Reader(const Reader &) = delete;
+        Reader &operator=(const Reader &) = delete;
+
+    public:
+        bool next(void);
+        unsigned int size(void) const;
+        unsigned int columnCount(void) const;
+        unsigned int rowNumber(void) const;
+        const std::vector<std::string> &getHeader(void) const;
+
+        template<typename Visitor>
+        unsigned int forEach(Visitor visit)
+        {
+            unsigned int rows = 0;
+            while (next())
+            {
+                visit(static_cast<const Reader &>(*this));
+                rows++;
+            }
+            return rows;
+        }
+
+    private:
+        const char *nextLine(const char *&eol);
+
+    private:
+        std::unique_ptr<MappedFile> _mapping;
+        std::string _pure;
+        const char *_begin;
+        const char *_cur;
+        const char *_end;
+        const char *_released;
+        const char _sep;
+        unsigned int _rowNumber;
+        std::vector<int> _slots;
+        std::size_t _columns;
+        std::vector<std::string> _header;
+        std::vector<std::string_view> _fields;
+
+    public:
+        std::string_view operator[](unsigned int) const;
+    };
 }
 
 #endif /*!_CSVPARSER_HPP_*/
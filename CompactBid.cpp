@@ -0,0 +1,354 @@
+//
+// Compact bid record with interned strings
+//
+
+#include <algorithm>
+#include <iostream>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "CSVparser.hpp"
+
+using namespace std;
+
+//============================================================================
+// String Pool class definition
+//============================================================================
+
+/**
+ * Class holding each distinct string once and handing out a small integer
+ * id for it, so records can refer to repeated text by id
+ */
+class StringPool {
+
+private:
+    // a deque never moves its elements, so the views used as keys stay valid
+    deque<string> strings;
+    unordered_map<string_view, uint32_t> ids;
+
+public:
+    uint32_t Intern(string_view text);
+    const string& Get(uint32_t id) const;
+    unsigned int Size() const;
+    size_t Bytes() const;
+};
+
+/**
+ * Get the id of a string, adding it to the pool the first time it is seen
+ * @param text the string to intern
+ * @return the id of the string
+ */
+uint32_t StringPool::Intern(string_view text) {
+    auto found = ids.find(text);
+    if (found != ids.end()) {
+        return found->second;
+    }
+    uint32_t id = strings.size();
+    strings.emplace_back(text);
+    ids.emplace(string_view(strings.back()), id);
+    return id;
+}
+
+/**
+ * Get the string for an id handed out by Intern
+ * @param id the id of the string
+ */
+const string& StringPool::Get(uint32_t id) const {
+    return strings.at(id);
+}
+
+/**
+ * Number of distinct strings in the pool
+ */
+unsigned int StringPool::Size() const {
+    return strings.size();
+}
+
+/**
+ * Approximate memory held by the pool: the strings, their heap buffers
+ * and one hash table entry per string
+ */
+size_t StringPool::Bytes() const {
+    size_t bytes = strings.size() * sizeof(string);
+    for (const string& text : strings) {
+        // short strings live inside the string object itself
+        if (text.capacity() > string().capacity()) {
+            bytes += text.capacity() + 1;
+        }
+    }
+    bytes += ids.bucket_count() * sizeof(void*);
+    bytes += ids.size() * (sizeof(pair<const string_view, uint32_t>) + sizeof(void*) + sizeof(size_t));
+    return bytes;
+}
+
+//============================================================================
+// Packed dates
+//============================================================================
+
+/**
+ * Pack a MM/DD/YYYY date into an integer that sorts chronologically:
+ * year in bits 9 and up, month in bits 5-8 and day in bits 0-4
+ * @param text the date to pack
+ * @param packed set to the packed date when the text is a valid date
+ * @return false if the text is not a MM/DD/YYYY date
+ */
+bool packDate(string_view text, uint32_t& packed) {
+    unsigned long long month, day, year;
+    if (text.size() != 10 || text[2] != '/' || text[5] != '/'
+            || !parseUnsigned(text.substr(0, 2), month)
+            || !parseUnsigned(text.substr(3, 2), day)
+            || !parseUnsigned(text.substr(6, 4), year)
+            || month < 1 || month > 12 || day < 1 || day > 31) {
+        return false;
+    }
+    packed = uint32_t(year << 9 | month << 5 | day);
+    return true;
+}
+
+/**
+ * Turn a packed date back into its MM/DD/YYYY text
+ * @param packed a date packed by packDate
+ */
+string unpackDate(uint32_t packed) {
+    // room for any year the 23 bits above the month can hold
+    char text[16];
+    snprintf(text, sizeof(text), "%02u/%02u/%04u", (packed >> 5) & 0xF, packed & 0x1F, packed >> 9);
+    return text;
+}
+
+//============================================================================
+// Compact Bid definition
+//============================================================================
+
+/**
+ * Bid stored in 40 bytes: integer id, amounts in cents, a packed date and
+ * pool ids for the text. A receipt number or date that isn't numeric is
+ * kept as text in the dictionary and flagged with the TEXT bit.
+ */
+struct CompactBid {
+    static constexpr uint64_t RECEIPT_TEXT = 1ull << 63;
+    static constexpr uint32_t DATE_TEXT = 1u << 31;
+
+    int64_t amount;         // cents
+    int64_t netSales;       // cents
+    uint64_t receiptNumber; // number, or text id | RECEIPT_TEXT
+    uint32_t bidId;
+    uint32_t title;         // title pool id
+    uint32_t datePaid;      // packed date, or text id | DATE_TEXT
+    uint16_t fund;          // fund pool id
+};
+
+//============================================================================
+// Bid Dictionary class definition
+//============================================================================
+
+/**
+ * Class holding the string pools a set of compact bids refer to, with the
+ * conversions between Bid and CompactBid
+ */
+class BidDictionary {
+
+private:
+    StringPool titles;
+    StringPool funds;
+    StringPool texts;
+    uint64_t receiptId(string_view receiptNumber);
+    uint32_t dateId(string_view datePaid);
+
+public:
+    CompactBid Compact(const Bid& bid);
+    CompactBid Compact(string_view bidId, string_view title, string_view fund, string_view datePaid,
+                       string_view receiptNumber, int64_t amount, int64_t netSales);
+    Bid Expand(const CompactBid& bid) const;
+    size_t Bytes() const;
+    static vector<CompactBid> loadBids(string csvPath, BidDictionary& dictionary);
+};
+
+/**
+ * Receipt numbers are stored as numbers, anything else goes in the text pool
+ */
+uint64_t BidDictionary::receiptId(string_view receiptNumber) {
+    unsigned long long number;
+    if (parseUnsigned(receiptNumber, number) && number < CompactBid::RECEIPT_TEXT
+            && to_string(number) == receiptNumber) {
+        return number;
+    }
+    return texts.Intern(receiptNumber) | CompactBid::RECEIPT_TEXT;
+}
+
+/**
+ * Dates are packed, anything else goes in the text pool
+ */
+uint32_t BidDictionary::dateId(string_view datePaid) {
+    uint32_t packed;
+    if (packDate(datePaid, packed) && unpackDate(packed) == datePaid) {
+        return packed;
+    }
+    return texts.Intern(datePaid) | CompactBid::DATE_TEXT;
+}
+
+/**
+ * Build a compact bid from the fields of a bid
+ * @throws invalid_argument if the bid id is not numeric
+ */
+CompactBid BidDictionary::Compact(string_view bidId, string_view title, string_view fund,
+                                  string_view datePaid, string_view receiptNumber,
+                                  int64_t amount, int64_t netSales) {
+    unsigned long long id;
+    if (!parseUnsigned(bidId, id) || id > UINT32_MAX || to_string(id) != bidId) {
+        throw invalid_argument("bid id " + string(bidId) + " is not numeric");
+    }
+    uint32_t fundId = funds.Intern(fund);
+    if (fundId > UINT16_MAX) {
+        throw length_error("too many distinct funds for a compact bid");
+    }
+
+    CompactBid compact;
+    compact.amount = amount;
+    compact.netSales = netSales;
+    compact.receiptNumber = receiptId(receiptNumber);
+    compact.bidId = uint32_t(id);
+    compact.title = titles.Intern(title);
+    compact.datePaid = dateId(datePaid);
+    compact.fund = uint16_t(fundId);
+    return compact;
+}
+
+/**
+ * Build a compact bid from a bid
+ * @param bid the bid to convert
+ */
+CompactBid BidDictionary::Compact(const Bid& bid) {
+    return Compact(bid.bidId, bid.title, bid.fund, bid.datePaid, bid.receiptNumber,
+                   llround(bid.amount * 100), llround(bid.netSales * 100));
+}
+
+/**
+ * Build the full bid back from a compact bid
+ * @param bid a compact bid made by this dictionary
+ */
+Bid BidDictionary::Expand(const CompactBid& bid) const {
+    Bid expanded;
+    expanded.bidId = to_string(bid.bidId);
+    expanded.title = titles.Get(bid.title);
+    expanded.fund = funds.Get(bid.fund);
+    expanded.datePaid = (bid.datePaid & CompactBid::DATE_TEXT)
+                        ? texts.Get(bid.datePaid & ~CompactBid::DATE_TEXT)
+                        : unpackDate(bid.datePaid);
+    expanded.receiptNumber = (bid.receiptNumber & CompactBid::RECEIPT_TEXT)
+                             ? texts.Get(uint32_t(bid.receiptNumber & ~CompactBid::RECEIPT_TEXT))
+                             : to_string(bid.receiptNumber);
+    expanded.amount = bid.amount / 100.0;
+    expanded.netSales = bid.netSales / 100.0;
+    return expanded;
+}
+
+/**
+ * Approximate memory held by all the string pools
+ */
+size_t BidDictionary::Bytes() const {
+    return titles.Bytes() + funds.Bytes() + texts.Bytes();
+}
+
+/**
+ * Load a CSV file of bids straight into compact bids, without building
+ * a Bid for each row
+ *
+ * @param csvPath the path to the CSV file to load
+ * @param dictionary the pools the compact bids will refer to
+ * @return a container holding all the compact bids read
+ */
+vector<CompactBid> BidDictionary::loadBids(string csvPath, BidDictionary& dictionary) {
+    vector<CompactBid> bids;
+
+    // initialize the CSV Reader, rows are parsed one at a time as they are loaded
+    // and only the bid columns are kept
+    csv::Reader file = csv::Reader(csvPath, csv::eMMAP, ',', BID_COLUMNS);
+
+    try {
+        // loop to read rows of a CSV file
+        while (file.next()) {
+            long long amount = 0, netSales = 0;
+            if (!parseCents(file[AMOUNT], amount)) {
+                amount = llround(strToDouble(file[AMOUNT], '$') * 100);
+            }
+            if (!parseCents(file[NET_SALES], netSales)) {
+                netSales = llround(strToDouble(file[NET_SALES], '$') * 100);
+            }
+
+            // push this bid to the end
+            bids.push_back(dictionary.Compact(file[BID_ID], file[TITLE], file[FUND], file[DATE_PAID],
+                                              file[RECEIPT_NUMBER], amount, netSales));
+        }
+    } catch (csv::Error &e) {
+        cerr << e.what() << endl;
+    }
+    return bids;
+}
+
+//============================================================================
+// Compact bid records
+//============================================================================
+
+/**
+ * Dictionary every container holding compact bids refers to, so a compact
+ * bid means the same wherever it is kept. The concurrent containers
+ * convert from several threads at once, so it is used under a lock that
+ * many threads can hold to expand bids but one to add strings.
+ */
+struct SharedBidDictionary {
+    static shared_mutex lock;
+    static BidDictionary dictionary;
+    static size_t Bytes();
+};
+
+shared_mutex SharedBidDictionary::lock;
+BidDictionary SharedBidDictionary::dictionary;
+
+/**
+ * Approximate memory held by the shared dictionary
+ */
+size_t SharedBidDictionary::Bytes() {
+    shared_lock<shared_mutex> guard(lock);
+    return dictionary.Bytes();
+}
+
+/**
+ * Turn a bid into a compact bid of the shared dictionary
+ * @throws invalid_argument if the bid id is not numeric
+ */
+template <>
+CompactBid packBid<CompactBid>(Bid bid) {
+    unique_lock<shared_mutex> guard(SharedBidDictionary::lock);
+    return SharedBidDictionary::dictionary.Compact(bid);
+}
+
+/**
+ * The bid a compact bid of the shared dictionary holds
+ */
+Bid toBid(const CompactBid& bid) {
+    shared_lock<shared_mutex> guard(SharedBidDictionary::lock);
+    return SharedBidDictionary::dictionary.Expand(bid);
+}
+
+/**
+ * Bid id of a compact bid
+ */
+string bidIdOf(const CompactBid& bid) {
+    return to_string(bid.bidId);
+}
+
+/**
+ * Winning bid of a compact bid in cents
+ */
+long long amountCentsOf(const CompactBid& bid) {
+    return bid.amount;
+}
@@ -0,0 +1,474 @@
+//
+// Hash table that can be searched from many threads while bids are added
+//
+
+#include <algorithm>
+#include <iostream>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include <string>
+
+#include "CSVparser.hpp"
+
+using namespace std;
+
+//============================================================================
+// Concurrent Hash Table class definition
+//============================================================================
+
+/**
+ * Class containing data members and methods to implement a hash table
+ * that any number of threads can use at once.
+ *
+ * Bids are spread over a fixed number of shards. Writers take the lock of
+ * the one shard a bid id belongs to, so writers on different shards never
+ * wait on each other. Readers take no lock: the key and bid of a node
+ * never change once it is linked into a chain, and replacing or removing
+ * a bid only swings the one atomic pointer that leads to its node, so
+ * Search walks the chain in a bounded number of steps whatever the
+ * writers are doing.
+ *
+ * Growing a shard relinks its nodes into the new bucket array rather than
+ * copying their bids, which can send a reader part way down a chain into
+ * another one. Each shard counts its grows, odd while one is under way,
+ * and a reader that misses while the count moved searches again under
+ * the shard lock.
+ *
+ * Unlinked nodes and outgrown bucket arrays may still be in use by a
+ * reader, so they are retired to the epoch reclaimer, which frees them
+ * once no reader can be holding them. Each shard takes its nodes from its
+ * own NodePool, which lives on after the table until the last retired
+ * node has gone back to it.
+ *
+ * Nodes hold their bid as Record, a Bid or a CompactBid, which Search
+ * expands once it has found the node.
+ */
+template <typename Record>
+class ConcurrentHashTableOf {
+
+private:
+    struct Pool;
+
+    struct Node {
+        unsigned int key;
+        Record bid;
+        atomic<Node*> next;
+        // where the node goes back to once the reclaimer frees it
+        Pool* pool;
+        Node(unsigned int key, Record bid, Node* next, Pool* pool)
+            : key(key), bid(move(bid)), next(next), pool(pool) {
+        }
+    };
+
+    // a shard's nodes, kept alive by the table and by every retired node
+    // the reclaimer has yet to free, which it may do from any thread
+    struct Pool {
+        mutex lock;
+        NodePool<Node> nodes;
+        size_t users = 1;
+    };
+
+    struct Buckets {
+        unsigned int mask;
+        unique_ptr<atomic<Node*>[]> heads;
+    };
+
+    // each shard on its own cache lines so writers don't share them
+    struct alignas(64) Shard {
+        mutex lock;
+        atomic<Buckets*> buckets;
+        // odd while the shard is growing
+        atomic<unsigned int> version;
+        unsigned int count;
+        Pool* pool;
+    };
+
+    static const unsigned int SHARD_BITS = 6;
+    static const unsigned int SHARDS = 1u << SHARD_BITS;
+    unique_ptr<Shard[]> shards;
+    static uint64_t Hash(unsigned int key);
+    static Shard& shardOf(Shard* shards, uint64_t hash);
+    static Buckets* newBuckets(unsigned int size);
+    static Node* newNode(Shard& shard, unsigned int key, Record bid, Node* next);
+    static void retireNode(Node* node);
+    static void destroyNode(void* node);
+    static void destroyBuckets(void* buckets);
+    static void release(Pool* pool);
+    static void grow(Shard& shard);
+    static const Node* find(const Shard& shard, unsigned int key, uint64_t hash);
+
+public:
+    ConcurrentHashTableOf();
+    ConcurrentHashTableOf(unsigned int size);
+    virtual ~ConcurrentHashTableOf();
+    ConcurrentHashTableOf(const ConcurrentHashTableOf&) = delete;
+    ConcurrentHashTableOf& operator=(const ConcurrentHashTableOf&) = delete;
+    void Insert(Bid bid);
+    void Remove(string bidId);
+    Bid Search(string bidId) const;
+    unsigned int Count();
+    static int getStringKey(string bidId);
+    static int loadBids(string, ConcurrentHashTableOf*);
+};
+
+using ConcurrentHashTable = ConcurrentHashTableOf<Bid>;
+
+/**
+ * Default constructor
+ */
+template <typename Record>
+ConcurrentHashTableOf<Record>::ConcurrentHashTableOf() : ConcurrentHashTableOf(17939) {
+}
+
+/**
+ * Constructor for the table sized to hold a number of bids without growing
+ * @param size number of bids expected
+ */
+template <typename Record>
+ConcurrentHashTableOf<Record>::ConcurrentHashTableOf(unsigned int size) : shards(new Shard[SHARDS]) {
+    unsigned int perShard = 4;
+    while (perShard < size / SHARDS + 1) {
+        perShard *= 2;
+    }
+    for (unsigned int i = 0; i < SHARDS; ++i) {
+        shards[i].buckets.store(newBuckets(perShard), memory_order_relaxed);
+        shards[i].version.store(0, memory_order_relaxed);
+        shards[i].count = 0;
+        shards[i].pool = new Pool;
+    }
+}
+
+/**
+ * Destructor, no thread may be using the table any more. Nodes retired
+ * earlier are freed by the reclaimer, so a shard's pool is only deleted
+ * here if none are left.
+ */
+template <typename Record>
+ConcurrentHashTableOf<Record>::~ConcurrentHashTableOf() {
+    for (unsigned int i = 0; i < SHARDS; ++i) {
+        Shard& shard = shards[i];
+        Buckets* buckets = shard.buckets.load(memory_order_relaxed);
+        {
+            lock_guard<mutex> guard(shard.pool->lock);
+            for (unsigned int b = 0; b <= buckets->mask; ++b) {
+                Node* node = buckets->heads[b].load(memory_order_relaxed);
+                while (node != nullptr) {
+                    Node* next = node->next.load(memory_order_relaxed);
+                    shard.pool->nodes.Delete(node);
+                    node = next;
+                }
+            }
+        }
+        delete buckets;
+        release(shard.pool);
+    }
+}
+
+/**
+ * Spread a bid id over 64 bits, the top bits pick the shard and the
+ * bits below them the bucket
+ */
+template <typename Record>
+uint64_t ConcurrentHashTableOf<Record>::Hash(unsigned int key) {
+    return key * 0x9E3779B97F4A7C15ull;
+}
+
+/**
+ * Get the shard a hashed key belongs to
+ */
+template <typename Record>
+typename ConcurrentHashTableOf<Record>::Shard& ConcurrentHashTableOf<Record>::shardOf(
+        Shard* shards, uint64_t hash) {
+    return shards[hash >> (64 - SHARD_BITS)];
+}
+
+/**
+ * Allocate an empty bucket array
+ * @param size number of buckets, a power of two
+ */
+template <typename Record>
+typename ConcurrentHashTableOf<Record>::Buckets* ConcurrentHashTableOf<Record>::newBuckets(
+        unsigned int size) {
+    Buckets* buckets = new Buckets;
+    buckets->mask = size - 1;
+    buckets->heads.reset(new atomic<Node*>[size]);
+    for (unsigned int i = 0; i < size; ++i) {
+        buckets->heads[i].store(nullptr, memory_order_relaxed);
+    }
+    return buckets;
+}
+
+/**
+ * Make a node from a shard's pool, the caller holds the shard lock
+ */
+template <typename Record>
+typename ConcurrentHashTableOf<Record>::Node* ConcurrentHashTableOf<Record>::newNode(
+        Shard& shard, unsigned int key, Record bid, Node* next) {
+    lock_guard<mutex> guard(shard.pool->lock);
+    return shard.pool->nodes.New(key, move(bid), next, shard.pool);
+}
+
+/**
+ * Hand an unlinked node to the epoch reclaimer, its pool is kept until
+ * the node has been freed
+ */
+template <typename Record>
+void ConcurrentHashTableOf<Record>::retireNode(Node* node) {
+    {
+        lock_guard<mutex> guard(node->pool->lock);
+        node->pool->users++;
+    }
+    // not under the pool lock, retiring may free other nodes of the pool
+    EpochReclaimer::Retire(node, destroyNode);
+}
+
+/**
+ * Free a node handed to the epoch reclaimer
+ */
+template <typename Record>
+void ConcurrentHashTableOf<Record>::destroyNode(void* node) {
+    Node* retired = static_cast<Node*>(node);
+    Pool* pool = retired->pool;
+    {
+        lock_guard<mutex> guard(pool->lock);
+        pool->nodes.Delete(retired);
+    }
+    release(pool);
+}
+
+/**
+ * Free a bucket array handed to the epoch reclaimer
+ */
+template <typename Record>
+void ConcurrentHashTableOf<Record>::destroyBuckets(void* buckets) {
+    delete static_cast<Buckets*>(buckets);
+}
+
+/**
+ * Drop one hold on a pool, deleting it once nothing uses it
+ */
+template <typename Record>
+void ConcurrentHashTableOf<Record>::release(Pool* pool) {
+    bool unused;
+    {
+        lock_guard<mutex> guard(pool->lock);
+        unused = --pool->users == 0;
+    }
+    if (unused) {
+        delete pool;
+    }
+}
+
+/**
+ * Double the buckets of a shard, the caller holds the shard lock. The
+ * nodes are moved onto the new chains as they are, so no bid is copied,
+ * and only the old bucket array is retired.
+ */
+template <typename Record>
+void ConcurrentHashTableOf<Record>::grow(Shard& shard) {
+    Buckets* old = shard.buckets.load(memory_order_relaxed);
+    Buckets* buckets = newBuckets((old->mask + 1) * 2);
+
+    // readers that see a relinked node also see the grow has started
+    unsigned int version = shard.version.load(memory_order_relaxed);
+    shard.version.store(version + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    for (unsigned int b = 0; b <= old->mask; ++b) {
+        Node* node = old->heads[b].load(memory_order_relaxed);
+        while (node != nullptr) {
+            Node* next = node->next.load(memory_order_relaxed);
+            atomic<Node*>& head = buckets->heads[(Hash(node->key) >> 32) & buckets->mask];
+            node->next.store(head.load(memory_order_relaxed), memory_order_relaxed);
+            head.store(node, memory_order_relaxed);
+            node = next;
+        }
+    }
+    shard.buckets.store(buckets, memory_order_release);
+    shard.version.store(version + 2, memory_order_release);
+    EpochReclaimer::Retire(old, destroyBuckets);
+}
+
+/**
+ * Walk the chain a key hashes to
+ * @return the node holding the key, or nullptr if there is none
+ */
+template <typename Record>
+const typename ConcurrentHashTableOf<Record>::Node* ConcurrentHashTableOf<Record>::find(
+        const Shard& shard, unsigned int key, uint64_t hash) {
+    const Buckets* buckets = shard.buckets.load(memory_order_acquire);
+    for (const Node* node = buckets->heads[(hash >> 32) & buckets->mask].load(memory_order_acquire);
+            node != nullptr; node = node->next.load(memory_order_acquire)) {
+        if (node->key == key) {
+            return node;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * Method to get the int value of the bid id from bid id string
+ * @param bidId bid id we would like to know int value for
+ * @return int value of bid id
+ */
+template <typename Record>
+int ConcurrentHashTableOf<Record>::getStringKey(string bidId) {
+    unsigned long long temp;
+    if (!parseUnsigned(bidId, temp) || temp > INT_MAX) {
+        throw invalid_argument("bid id " + bidId + " is not numeric");
+    }
+    return int(temp);
+}
+
+/**
+ * Insert a bid, replacing any bid with the same id
+ *
+ * @param bid The bid to insert
+ */
+template <typename Record>
+void ConcurrentHashTableOf<Record>::Insert(Bid bid) {
+    unsigned int key = getStringKey(bid.bidId);
+    uint64_t hash = Hash(key);
+    Shard& shard = shardOf(shards.get(), hash);
+    // packed before the shard lock is taken
+    Record record = packBid<Record>(move(bid));
+    lock_guard<mutex> guard(shard.lock);
+
+    Buckets* buckets = shard.buckets.load(memory_order_relaxed);
+    atomic<Node*>* link = &buckets->heads[(hash >> 32) & buckets->mask];
+    for (Node* node = link->load(memory_order_relaxed); node != nullptr;
+            node = node->next.load(memory_order_relaxed)) {
+        if (node->key == key) {
+            // swap in a new node in place of the old one
+            Node* replacement = newNode(shard, key, move(record), node->next.load(memory_order_relaxed));
+            link->store(replacement, memory_order_release);
+            retireNode(node);
+            return;
+        }
+        link = &node->next;
+    }
+
+    if (shard.count + 1 > buckets->mask + 1) {
+        grow(shard);
+        buckets = shard.buckets.load(memory_order_relaxed);
+    }
+    atomic<Node*>& head = buckets->heads[(hash >> 32) & buckets->mask];
+    head.store(newNode(shard, key, move(record), head.load(memory_order_relaxed)), memory_order_release);
+    shard.count++;
+}
+
+/**
+ * Remove a bid
+ *
+ * @param bidId The bid id to search for
+ */
+template <typename Record>
+void ConcurrentHashTableOf<Record>::Remove(string bidId) {
+    unsigned int key = getStringKey(bidId);
+    uint64_t hash = Hash(key);
+    Shard& shard = shardOf(shards.get(), hash);
+    lock_guard<mutex> guard(shard.lock);
+
+    Buckets* buckets = shard.buckets.load(memory_order_relaxed);
+    atomic<Node*>* link = &buckets->heads[(hash >> 32) & buckets->mask];
+    for (Node* node = link->load(memory_order_relaxed); node != nullptr;
+            node = node->next.load(memory_order_relaxed)) {
+        if (node->key == key) {
+            // readers already on the node still see the rest of the chain
+            link->store(node->next.load(memory_order_relaxed), memory_order_release);
+            retireNode(node);
+            shard.count--;
+            return;
+        }
+        link = &node->next;
+    }
+}
+
+/**
+ * Search for the specified bidId without taking any lock unless the
+ * shard grew during the search, the epoch guard keeps the nodes it walks
+ * from being freed under it
+ *
+ * @param bidId The bid id to search for
+ * @return the bid, or an empty bid if it is not found
+ */
+template <typename Record>
+Bid ConcurrentHashTableOf<Record>::Search(string bidId) const {
+    unsigned int key = getStringKey(bidId);
+    uint64_t hash = Hash(key);
+    Shard& shard = shardOf(shards.get(), hash);
+    EpochReclaimer::Guard guard;
+
+    unsigned int version = shard.version.load(memory_order_acquire);
+    if (version % 2 == 0) {
+        const Node* node = find(shard, key, hash);
+        if (node != nullptr) {
+            return toBid(node->bid);
+        }
+        // a miss only counts if no grow relinked the chain under the walk
+        atomic_thread_fence(memory_order_acquire);
+        if (shard.version.load(memory_order_relaxed) == version) {
+            return Bid();
+        }
+    }
+    lock_guard<mutex> lock(shard.lock);
+    const Node* node = find(shard, key, hash);
+    return node != nullptr ? Bid(toBid(node->bid)) : Bid();
+}
+
+/**
+ * Number of bids in the table
+ */
+template <typename Record>
+unsigned int ConcurrentHashTableOf<Record>::Count() {
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < SHARDS; ++i) {
+        lock_guard<mutex> guard(shards[i].lock);
+        count += shards[i].count;
+    }
+    return count;
+}
+
+/**
+ * Load a CSV file containing bids into a container
+ *
+ * @param csvPath the path to the CSV file to load
+ * @param table the table to add the bids to
+ * @return the number of bids read
+ */
+template <typename Record>
+int ConcurrentHashTableOf<Record>::loadBids(string csvPath, ConcurrentHashTableOf* table) {
+    int numBids = 0;
+
+    // initialize the CSV Reader, rows are parsed one at a time as they are loaded
+    // and only the bid columns are kept
+    csv::Reader file = csv::Reader(csvPath, csv::eMMAP, ',', BID_COLUMNS);
+
+    try {
+        // loop to read rows of a CSV file
+        while (file.next()) {
+
+            // Create a data structure and add to the collection of bids
+            Bid bid;
+            bid.bidId = string(file[BID_ID]);
+            bid.title = string(file[TITLE]);
+            bid.fund = string(file[FUND]);
+            bid.datePaid = string(file[DATE_PAID]);
+            bid.receiptNumber = string(file[RECEIPT_NUMBER]);
+            bid.netSales = currencyToDouble(file[NET_SALES]);
+            bid.amount = currencyToDouble(file[AMOUNT]);
+
+            // push this bid to the end
+            table->Insert(move(bid));
+            numBids++;
+        }
+    } catch (csv::Error &e) {
+        cerr << e.what() << endl;
+    }
+    return numBids;
+}
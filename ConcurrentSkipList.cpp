@@ -0,0 +1,451 @@
+//
+// Lock-free skip list of bids ordered by id
+//
+
+#include <algorithm>
+#include <iostream>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <stdexcept>
+#include <unordered_set>
+#include <vector>
+#include <string>
+
+#include "CSVparser.hpp"
+
+using namespace std;
+
+//============================================================================
+// Concurrent Skip List class definition
+//============================================================================
+
+/**
+ * Class containing data members and methods to implement a skip list of
+ * bids ordered by integer bid id that any number of threads can insert
+ * into, remove from and read at once without locks.
+ *
+ * Every level is a lock-free sorted linked list. A node is removed by
+ * marking the low bit of its next pointers, top level first, and whoever
+ * marks the bottom level has removed it; marked nodes are then unlinked
+ * by any thread that walks past them. A node counts the levels it is
+ * linked on, and the thread that unlinks the last one retires it to the
+ * epoch reclaimer, which frees it once no reader can be holding it.
+ *
+ * A node's bid is a Record, either a Bid or a CompactBid that is expanded
+ * for Search and Range.
+ */
+template <typename Record>
+class ConcurrentSkipListOf {
+
+private:
+    static constexpr int MAX_LEVEL = 24;
+    static const uintptr_t MARK = 1;
+
+    struct Node {
+        uint64_t key;
+        Record bid;
+        int levels;
+        // levels the node is linked on, plus one while it is being inserted
+        atomic<int> links;
+        atomic<uintptr_t>* next;
+
+        Node(uint64_t key, Record bid, int levels) : key(key), bid(move(bid)), levels(levels), links(0) {
+            next = new atomic<uintptr_t>[levels];
+            for (int i = 0; i < levels; ++i) {
+                next[i].store(0, memory_order_relaxed);
+            }
+        }
+        ~Node() {
+            delete[] next;
+        }
+    };
+
+    Node* head;
+    Node* tail;
+    atomic<long> count;
+    static Node* pointer(uintptr_t link);
+    static bool marked(uintptr_t link);
+    static uintptr_t link(Node* node);
+    static int randomLevel();
+    static void destroyNode(void* node);
+    static void unlinked(Node* node);
+    bool find(uint64_t key, Node** preds, Node** succs);
+
+public:
+    ConcurrentSkipListOf();
+    virtual ~ConcurrentSkipListOf();
+    ConcurrentSkipListOf(const ConcurrentSkipListOf&) = delete;
+    ConcurrentSkipListOf& operator=(const ConcurrentSkipListOf&) = delete;
+    bool Insert(Bid bid);
+    bool Remove(string bidId);
+    Bid Search(string bidId) const;
+    template <typename Visitor> void Range(unsigned int first, unsigned int last, Visitor visit) const;
+    long Count() const;
+    static unsigned int getStringKey(string bidId);
+    static int loadBids(string, ConcurrentSkipListOf*);
+};
+
+using ConcurrentSkipList = ConcurrentSkipListOf<Bid>;
+
+/**
+ * Default constructor
+ */
+template <typename Record>
+ConcurrentSkipListOf<Record>::ConcurrentSkipListOf() : count(0) {
+    // sentinels at either end, bid ids are never above UINT_MAX
+    head = new Node(0, Record(), MAX_LEVEL);
+    tail = new Node(UINT64_MAX, Record(), MAX_LEVEL);
+    for (int i = 0; i < MAX_LEVEL; ++i) {
+        head->next[i].store(link(tail), memory_order_relaxed);
+    }
+}
+
+/**
+ * Destructor, no thread may be using the list any more
+ */
+template <typename Record>
+ConcurrentSkipListOf<Record>::~ConcurrentSkipListOf() {
+    // a node unlinked from the bottom may still hang on a higher level
+    unordered_set<Node*> nodes;
+    for (int level = 0; level < MAX_LEVEL; ++level) {
+        for (Node* node = pointer(head->next[level].load()); node != tail;
+                node = pointer(node->next[level].load())) {
+            nodes.insert(node);
+        }
+    }
+    for (Node* node : nodes) {
+        delete node;
+    }
+    delete head;
+    delete tail;
+}
+
+/**
+ * Node a link points at, without its mark
+ */
+template <typename Record>
+typename ConcurrentSkipListOf<Record>::Node* ConcurrentSkipListOf<Record>::pointer(uintptr_t link) {
+    return reinterpret_cast<Node*>(link & ~MARK);
+}
+
+/**
+ * Whether the node owning a link has been removed
+ */
+template <typename Record>
+bool ConcurrentSkipListOf<Record>::marked(uintptr_t link) {
+    return link & MARK;
+}
+
+/**
+ * Unmarked link to a node
+ */
+template <typename Record>
+uintptr_t ConcurrentSkipListOf<Record>::link(Node* node) {
+    return reinterpret_cast<uintptr_t>(node);
+}
+
+/**
+ * Pick the number of levels for a new node, each level half as likely
+ * as the one below it
+ */
+template <typename Record>
+int ConcurrentSkipListOf<Record>::randomLevel() {
+    static thread_local uint64_t seed = 0x9E3779B97F4A7C15ull ^ reinterpret_cast<uintptr_t>(&seed);
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return min(MAX_LEVEL, 1 + __builtin_ctzll(seed | (1ull << 63)));
+}
+
+/**
+ * Free a node handed to the epoch reclaimer
+ */
+template <typename Record>
+void ConcurrentSkipListOf<Record>::destroyNode(void* node) {
+    delete static_cast<Node*>(node);
+}
+
+/**
+ * Count one fewer level the node is linked on, retiring it after the last
+ */
+template <typename Record>
+void ConcurrentSkipListOf<Record>::unlinked(Node* node) {
+    if (node->links.fetch_sub(1, memory_order_acq_rel) == 1) {
+        EpochReclaimer::Retire(node, destroyNode);
+    }
+}
+
+/**
+ * Find the nodes either side of a key on every level, unlinking any
+ * removed nodes on the way. The caller holds an epoch guard.
+ * @param key the bid id to look for
+ * @param preds set to the last node before the key on each level
+ * @param succs set to the first node at or after the key on each level
+ * @return true if a node with the key is in the list
+ */
+template <typename Record>
+bool ConcurrentSkipListOf<Record>::find(uint64_t key, Node** preds, Node** succs) {
+retry:
+    Node* pred = head;
+    for (int level = MAX_LEVEL - 1; level >= 0; --level) {
+        Node* curr = pointer(pred->next[level].load(memory_order_acquire));
+        while (true) {
+            uintptr_t succ = curr->next[level].load(memory_order_acquire);
+            while (marked(succ)) {
+                // unlink the removed node, starting over if pred changed
+                uintptr_t expected = link(curr);
+                if (!pred->next[level].compare_exchange_strong(expected, link(pointer(succ)),
+                                                                memory_order_acq_rel)) {
+                    goto retry;
+                }
+                unlinked(curr);
+                curr = pointer(succ);
+                succ = curr->next[level].load(memory_order_acquire);
+            }
+            if (curr->key < key) {
+                pred = curr;
+                curr = pointer(succ);
+            } else {
+                break;
+            }
+        }
+        preds[level] = pred;
+        succs[level] = curr;
+    }
+    return succs[0]->key == key;
+}
+
+/**
+ * Method to get the int value of the bid id from bid id string
+ * @param bidId bid id we would like to know int value for
+ * @return int value of bid id
+ */
+template <typename Record>
+unsigned int ConcurrentSkipListOf<Record>::getStringKey(string bidId) {
+    unsigned long long temp;
+    if (!parseUnsigned(bidId, temp) || temp > UINT_MAX) {
+        throw invalid_argument("bid id " + bidId + " is not numeric");
+    }
+    return (unsigned int) temp;
+}
+
+/**
+ * Insert a bid
+ *
+ * @param bid The bid to insert
+ * @return false if a bid with the same id is already in the list
+ */
+template <typename Record>
+bool ConcurrentSkipListOf<Record>::Insert(Bid bid) {
+    uint64_t key = getStringKey(bid.bidId);
+    EpochReclaimer::Guard guard;
+    Node* preds[MAX_LEVEL];
+    Node* succs[MAX_LEVEL];
+    int levels = randomLevel();
+    Record record = packBid<Record>(move(bid));
+
+    Node* node;
+    while (true) {
+        if (find(key, preds, succs)) {
+            return false;
+        }
+        node = new Node(key, move(record), levels);
+        node->links.store(2, memory_order_relaxed);
+        for (int i = 0; i < levels; ++i) {
+            node->next[i].store(link(succs[i]), memory_order_relaxed);
+        }
+        // linking the bottom level is what adds the bid
+        uintptr_t expected = link(succs[0]);
+        if (preds[0]->next[0].compare_exchange_strong(expected, link(node), memory_order_acq_rel)) {
+            break;
+        }
+        // nobody else ever saw the node, take the bid back for the next try
+        record = move(node->bid);
+        delete node;
+    }
+    count.fetch_add(1, memory_order_relaxed);
+
+    // the upper levels are only shortcuts, stop if the node is removed meanwhile
+    for (int level = 1; level < levels; ++level) {
+        while (true) {
+            uintptr_t next = node->next[level].load(memory_order_acquire);
+            if (marked(next)) {
+                goto linked;
+            }
+            if (pointer(next) != succs[level]
+                    && !node->next[level].compare_exchange_strong(next, link(succs[level]),
+                                                                   memory_order_acq_rel)) {
+                continue;
+            }
+            node->links.fetch_add(1, memory_order_relaxed);
+            uintptr_t expected = link(succs[level]);
+            if (preds[level]->next[level].compare_exchange_strong(expected, link(node),
+                                                                   memory_order_acq_rel)) {
+                // removed while being linked here, make sure it comes off again
+                if (marked(node->next[level].load(memory_order_acquire))) {
+                    find(key, preds, succs);
+                }
+                break;
+            }
+            node->links.fetch_sub(1, memory_order_relaxed);
+            find(key, preds, succs);
+            if (succs[0] != node) {
+                goto linked;
+            }
+        }
+    }
+linked:
+    unlinked(node);
+    return true;
+}
+
+/**
+ * Remove a bid
+ *
+ * @param bidId The bid id to remove
+ * @return false if the bid is not in the list
+ */
+template <typename Record>
+bool ConcurrentSkipListOf<Record>::Remove(string bidId) {
+    uint64_t key = getStringKey(bidId);
+    EpochReclaimer::Guard guard;
+    Node* preds[MAX_LEVEL];
+    Node* succs[MAX_LEVEL];
+
+    if (!find(key, preds, succs)) {
+        return false;
+    }
+    Node* node = succs[0];
+    for (int level = node->levels - 1; level >= 1; --level) {
+        uintptr_t next = node->next[level].load(memory_order_acquire);
+        while (!marked(next)) {
+            node->next[level].compare_exchange_weak(next, next | MARK, memory_order_acq_rel);
+        }
+    }
+
+    // only one thread gets to mark the bottom level
+    uintptr_t next = node->next[0].load(memory_order_acquire);
+    while (!marked(next)) {
+        if (node->next[0].compare_exchange_weak(next, next | MARK, memory_order_acq_rel)) {
+            count.fetch_sub(1, memory_order_relaxed);
+            find(key, preds, succs);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Search for the specified bidId without changing the list
+ *
+ * @param bidId The bid id to search for
+ * @return the bid, or an empty bid if it is not found
+ */
+template <typename Record>
+Bid ConcurrentSkipListOf<Record>::Search(string bidId) const {
+    uint64_t key = getStringKey(bidId);
+    EpochReclaimer::Guard guard;
+
+    Node* pred = head;
+    Node* curr = nullptr;
+    for (int level = MAX_LEVEL - 1; level >= 0; --level) {
+        curr = pointer(pred->next[level].load(memory_order_acquire));
+        while (true) {
+            uintptr_t succ = curr->next[level].load(memory_order_acquire);
+            // step over removed nodes rather than unlinking them
+            while (marked(succ)) {
+                curr = pointer(succ);
+                succ = curr->next[level].load(memory_order_acquire);
+            }
+            if (curr->key < key) {
+                pred = curr;
+                curr = pointer(succ);
+            } else {
+                break;
+            }
+        }
+    }
+    if (curr->key == key && !marked(curr->next[0].load(memory_order_acquire))) {
+        return toBid(curr->bid);
+    }
+    return Bid();
+}
+
+/**
+ * Visit every bid with an id from first to last, in id order. Bids
+ * added or removed during the walk may or may not be seen.
+ *
+ * @param first the lowest bid id to visit
+ * @param last the highest bid id to visit
+ * @param visit called with each bid
+ */
+template <typename Record>
+template <typename Visitor>
+void ConcurrentSkipListOf<Record>::Range(unsigned int first, unsigned int last, Visitor visit) const {
+    EpochReclaimer::Guard guard;
+
+    // drop down to the bottom level just before first
+    Node* pred = head;
+    for (int level = MAX_LEVEL - 1; level >= 0; --level) {
+        Node* curr = pointer(pred->next[level].load(memory_order_acquire));
+        while (curr->key < first) {
+            pred = curr;
+            curr = pointer(curr->next[level].load(memory_order_acquire));
+        }
+    }
+    for (Node* node = pointer(pred->next[0].load(memory_order_acquire)); node->key <= last; ) {
+        uintptr_t next = node->next[0].load(memory_order_acquire);
+        if (node->key >= first && !marked(next)) {
+            visit(toBid(node->bid));
+        }
+        node = pointer(next);
+    }
+}
+
+/**
+ * Number of bids in the list
+ */
+template <typename Record>
+long ConcurrentSkipListOf<Record>::Count() const {
+    return count.load(memory_order_relaxed);
+}
+
+/**
+ * Load a CSV file containing bids into a container
+ *
+ * @param csvPath the path to the CSV file to load
+ * @param list the list to add the bids to
+ * @return the number of bids read
+ */
+template <typename Record>
+int ConcurrentSkipListOf<Record>::loadBids(string csvPath, ConcurrentSkipListOf* list) {
+    int numBids = 0;
+
+    // initialize the CSV Reader, rows are parsed one at a time as they are loaded
+    // and only the bid columns are kept
+    csv::Reader file = csv::Reader(csvPath, csv::eMMAP, ',', BID_COLUMNS);
+
+    try {
+        // loop to read rows of a CSV file
+        while (file.next()) {
+
+            // Create a data structure and add to the collection of bids
+            Bid bid;
+            bid.bidId = string(file[BID_ID]);
+            bid.title = string(file[TITLE]);
+            bid.fund = string(file[FUND]);
+            bid.datePaid = string(file[DATE_PAID]);
+            bid.receiptNumber = string(file[RECEIPT_NUMBER]);
+            bid.netSales = currencyToDouble(file[NET_SALES]);
+            bid.amount = currencyToDouble(file[AMOUNT]);
+
+            // push this bid to the end
+            list->Insert(move(bid));
+            numBids++;
+        }
+    } catch (csv::Error &e) {
+        cerr << e.what() << endl;
+    }
+    return numBids;
+}
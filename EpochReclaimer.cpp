@@ -0,0 +1,205 @@
+//
+// Epoch based reclamation of memory unlinked from lock-free structures
+//
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+//============================================================================
+// Epoch Reclaimer class definition
+//============================================================================
+
+/**
+ * Class that decides when memory unlinked from a lock-free structure can
+ * be freed. A thread announces the global epoch while it is reading the
+ * structure (for as long as a Guard lives) and anything unlinked is
+ * retired with the epoch it was retired in. The epoch only moves on once
+ * every reading thread has seen the current one, so once it has moved on
+ * twice no thread can still hold a pointer to the retired object.
+ */
+class EpochReclaimer {
+
+private:
+    static const unsigned int MAX_THREADS = 256;
+    static const uint64_t IDLE = UINT64_MAX;
+    // retired objects a thread collects before it tries to free them
+    static const size_t COLLECT_EVERY = 64;
+
+    struct alignas(64) Slot {
+        atomic<uint64_t> epoch;
+        atomic<bool> owned;
+    };
+
+    struct Retired {
+        uint64_t epoch;
+        void* object;
+        void (*destroy)(void*);
+    };
+
+    // each thread's slot and retired objects, handed back when it exits
+    struct ThreadState {
+        int slot = -1;
+        unsigned int depth = 0;
+        vector<Retired> retired;
+        ~ThreadState();
+    };
+
+    static Slot slots[MAX_THREADS];
+    static atomic<uint64_t> globalEpoch;
+    static atomic<unsigned long> freed;
+    static mutex orphanLock;
+    static vector<Retired> orphans;
+    static thread_local ThreadState state;
+    static void enter();
+    static void leave();
+    static void tryAdvance();
+    static void collect(vector<Retired>& retired);
+
+public:
+    /**
+     * Keeps everything reachable when it was created alive until it is
+     * destroyed, guards can be nested
+     */
+    class Guard {
+    public:
+        Guard() { enter(); }
+        ~Guard() { leave(); }
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+    };
+
+    static void Retire(void* object, void (*destroy)(void*));
+    static void Collect();
+    static unsigned long Freed();
+};
+
+EpochReclaimer::Slot EpochReclaimer::slots[EpochReclaimer::MAX_THREADS] = {};
+atomic<uint64_t> EpochReclaimer::globalEpoch(0);
+atomic<unsigned long> EpochReclaimer::freed(0);
+mutex EpochReclaimer::orphanLock;
+vector<EpochReclaimer::Retired> EpochReclaimer::orphans;
+thread_local EpochReclaimer::ThreadState EpochReclaimer::state;
+
+/**
+ * Give up the thread's slot and leave what it retired to other threads
+ */
+EpochReclaimer::ThreadState::~ThreadState() {
+    if (slot >= 0) {
+        slots[slot].epoch.store(IDLE, memory_order_release);
+        slots[slot].owned.store(false, memory_order_release);
+    }
+    lock_guard<mutex> guard(orphanLock);
+    orphans.insert(orphans.end(), retired.begin(), retired.end());
+}
+
+/**
+ * Announce the current epoch, claiming a slot the first time a thread
+ * reads a structure
+ */
+void EpochReclaimer::enter() {
+    if (state.slot < 0) {
+        for (unsigned int i = 0; i < MAX_THREADS && state.slot < 0; ++i) {
+            bool expected = false;
+            if (slots[i].owned.compare_exchange_strong(expected, true)) {
+                slots[i].epoch.store(IDLE, memory_order_relaxed);
+                state.slot = i;
+            }
+        }
+        if (state.slot < 0) {
+            throw runtime_error("EpochReclaimer : too many threads");
+        }
+    }
+    if (state.depth++ == 0) {
+        slots[state.slot].epoch.store(globalEpoch.load(memory_order_relaxed), memory_order_seq_cst);
+        // the announcement must be seen before any pointer is read
+        atomic_thread_fence(memory_order_seq_cst);
+    }
+}
+
+/**
+ * Stop reading, the thread no longer holds back the epoch
+ */
+void EpochReclaimer::leave() {
+    if (--state.depth == 0) {
+        slots[state.slot].epoch.store(IDLE, memory_order_release);
+    }
+}
+
+/**
+ * Move the epoch on if every thread that is reading has seen it
+ */
+void EpochReclaimer::tryAdvance() {
+    uint64_t epoch = globalEpoch.load(memory_order_seq_cst);
+    for (unsigned int i = 0; i < MAX_THREADS; ++i) {
+        if (!slots[i].owned.load(memory_order_acquire)) {
+            continue;
+        }
+        uint64_t seen = slots[i].epoch.load(memory_order_seq_cst);
+        if (seen != IDLE && seen != epoch) {
+            return;
+        }
+    }
+    globalEpoch.compare_exchange_strong(epoch, epoch + 1);
+}
+
+/**
+ * Free every retired object no thread can still be reading
+ * @param retired objects to check, the ones freed are taken out
+ */
+void EpochReclaimer::collect(vector<Retired>& retired) {
+    uint64_t epoch = globalEpoch.load(memory_order_acquire);
+    size_t kept = 0;
+    for (Retired& entry : retired) {
+        if (entry.epoch + 2 <= epoch) {
+            entry.destroy(entry.object);
+            freed.fetch_add(1, memory_order_relaxed);
+        } else {
+            retired[kept++] = entry;
+        }
+    }
+    retired.resize(kept);
+}
+
+/**
+ * Hand over an object that has been unlinked, it is freed once no
+ * thread can still be reading it
+ * @param object the unlinked object
+ * @param destroy frees the object
+ */
+void EpochReclaimer::Retire(void* object, void (*destroy)(void*)) {
+    state.retired.push_back({globalEpoch.load(memory_order_seq_cst), object, destroy});
+    if (state.retired.size() % COLLECT_EVERY == 0) {
+        tryAdvance();
+        collect(state.retired);
+        // never wait here, another thread will get to the orphans
+        unique_lock<mutex> guard(orphanLock, try_to_lock);
+        if (guard.owns_lock()) {
+            collect(orphans);
+        }
+    }
+}
+
+/**
+ * Free whatever retired objects can be freed now, including those left
+ * by threads that have exited. When no other thread is reading this
+ * frees everything.
+ */
+void EpochReclaimer::Collect() {
+    tryAdvance();
+    tryAdvance();
+    collect(state.retired);
+    lock_guard<mutex> guard(orphanLock);
+    collect(orphans);
+}
+
+/**
+ * Number of retired objects freed so far
+ */
+unsigned long EpochReclaimer::Freed() {
+    return freed.load(memory_order_relaxed);
+}
@@ -6,6 +6,7 @@
 #include <iostream>
 #include <time.h>
 #include <climits>
+#include <stdexcept>
 #include <vector>
 #include <string>
 
@@ -17,86 +18,165 @@ using namespace std;
 //============================================================================
 
 /**
- * Class containing data members and methods to
- * implement a hash table with chaining.
+ * Class containing data members and methods to implement a hash table
+ * with open addressing and Robin Hood probing. Keys live inline in the
+ * slot array so a probe never leaves it; the bids themselves are kept
+ * packed in a separate vector, as Record, Bid or CompactBid. The table doubles once it passes its
+ * maximum load factor, so any number of colliding bids can be stored.
  */
-class HashTable {
+template <typename Record>
+class HashTableOf {
 
 private:
-    // structures to hold bids
-    struct Node {
-        Bid bid;
+    // distance is 0 for an empty slot, otherwise 1 + how far the entry
+    // sits from the slot its key hashes to
+    struct Slot {
         unsigned int key;
-        Node *next;
-        // default constructor
-        Node() {
-            key = UINT_MAX;
-            next = nullptr;
-        }
-        // initialize with a bid
-        Node(Bid aBid) : Node() {
-            bid = aBid;
-        }
-        // initialize with a bid and a key
-        Node(Bid aBid, unsigned int aKey) : Node(aBid) {
-            key = aKey;
-        }
+        unsigned int index;
+        unsigned int distance;
     };
-    const unsigned int DEFAULT_SIZE = 17939;
-    unsigned int key;
-    vector<Node> nodes;
-    unsigned int tableSize = DEFAULT_SIZE;
-    unsigned int Hash(unsigned int key);
+    static const unsigned int DEFAULT_SIZE = 17939;
+    vector<Slot> slots;
+    vector<Record> bids;
+    unsigned int mask;
+    unsigned int shift;
+    float maxLoadFactor;
+    unsigned int Hash(unsigned int key) const;
+    int findSlot(unsigned int key) const;
+    void placeSlot(Slot entry);
+    void resize(unsigned int capacity);
 
 public:
-    HashTable();
-    virtual ~HashTable();
-    HashTable(unsigned int size);
+    HashTableOf();
+    virtual ~HashTableOf();
+    HashTableOf(unsigned int size, float maxLoadFactor = 0.875f);
     void Insert(Bid bid);
     void PrintAll();
     void Remove(string bidId);
     Bid Search(string bidId);
-    int getBidKey(Bid bid);
+    void SearchBatch(const string* bidIds, size_t count, Bid* results);
+    vector<Bid> SearchBatch(const vector<string>& bidIds);
+    int getBidKey(const Bid& bid);
     bool Size();
+    unsigned int Count() const;
+    unsigned int Capacity() const;
     int getStringKey(string bidId);
-    static int loadBids(string, HashTable*);
+    static bool parseKey(const string& bidId, unsigned int& key);
+    static int loadBids(string, HashTableOf*);
 };
 
+using HashTable = HashTableOf<Bid>;
+
 /**
  * Default constructor
  */
-HashTable::HashTable() {
-    nodes.resize(tableSize);
+template <typename Record>
+HashTableOf<Record>::HashTableOf() : HashTableOf(DEFAULT_SIZE) {
 }
 
 /**
- * Constructor for the HashTable using the table size
- * to resize the table
- * @param size is size of the hash table
+ * Constructor for the HashTable sized to hold a number of bids
+ * without growing
+ * @param size number of bids expected
+ * @param maxLoadFactor fraction of slots that may be used before the
+ *                      table doubles
  */
-HashTable::HashTable(unsigned int size){
-    this->tableSize = size;
-    nodes.resize(size);
+template <typename Record>
+HashTableOf<Record>::HashTableOf(unsigned int size, float maxLoadFactor) {
+    if (maxLoadFactor <= 0.0f || maxLoadFactor >= 1.0f) {
+        throw invalid_argument("load factor must be between 0 and 1");
+    }
+    this->maxLoadFactor = maxLoadFactor;
 
+    unsigned int capacity = 16;
+    while (capacity * maxLoadFactor < size) {
+        capacity *= 2;
+    }
+    resize(capacity);
+    bids.reserve(size);
 }
+
 /**
  * Destructor
  */
-HashTable::~HashTable() {
-    for (int i = 0; i < tableSize; ++i) {
-        nodes.erase(nodes.begin() + i);
-    }
+template <typename Record>
+HashTableOf<Record>::~HashTableOf() {
 }
 
 /**
- * Method to get the hashed value of an int
+ * Method to get the slot a key belongs in. Bid ids are close together,
+ * so they are spread with Fibonacci hashing instead of a plain modulo
  * @param key the value to be hashed
  * @return unsigned int of the hashed value
  */
-unsigned int HashTable::Hash(unsigned int key) {
-    unsigned int hash;
-    hash = key % tableSize;
-    return hash;
+template <typename Record>
+unsigned int HashTableOf<Record>::Hash(unsigned int key) const {
+    return (key * 2654435769u) >> shift;
+}
+
+/**
+ * Method to find the slot holding a key
+ * @param key the key to look for
+ * @return position of the slot, -1 if the key is not in the table
+ */
+template <typename Record>
+int HashTableOf<Record>::findSlot(unsigned int key) const {
+    unsigned int position = Hash(key);
+    for (unsigned int distance = 1; ; ++distance) {
+        const Slot& slot = slots[position];
+        // an empty slot or one closer to home than we are ends the search
+        if (slot.distance < distance) {
+            return -1;
+        }
+        if (slot.key == key) {
+            return position;
+        }
+        position = (position + 1) & mask;
+    }
+}
+
+/**
+ * Method to place an entry, taking the slot of any entry that sits
+ * closer to its home than the one being placed (Robin Hood)
+ * @param entry the key and bid index to place
+ */
+template <typename Record>
+void HashTableOf<Record>::placeSlot(Slot entry) {
+    unsigned int position = Hash(entry.key);
+    entry.distance = 1;
+    while (true) {
+        Slot& slot = slots[position];
+        if (slot.distance == 0) {
+            slot = entry;
+            return;
+        }
+        if (slot.distance < entry.distance) {
+            swap(slot, entry);
+        }
+        position = (position + 1) & mask;
+        entry.distance++;
+    }
+}
+
+/**
+ * Method to rebuild the slot array with a new number of slots
+ * @param capacity number of slots, a power of two
+ */
+template <typename Record>
+void HashTableOf<Record>::resize(unsigned int capacity) {
+    vector<Slot> old(capacity, Slot{0, 0, 0});
+    old.swap(slots);
+    mask = capacity - 1;
+    shift = 32;
+    for (unsigned int bits = capacity; bits > 1; bits >>= 1) {
+        --shift;
+    }
+
+    for (const Slot& slot : old) {
+        if (slot.distance != 0) {
+            placeSlot(slot);
+        }
+    }
 }
 
 /**
@@ -104,9 +184,9 @@ unsigned int HashTable::Hash(unsigned int key) {
  * @param bid bid in question
  * @return the bid id as an int
  */
-int HashTable::getBidKey(Bid bid) {
-    int temp = stoi(bid.bidId);
-    return temp;
+template <typename Record>
+int HashTableOf<Record>::getBidKey(const Bid& bid) {
+    return getStringKey(bid.bidId);
 }
 
 /**
@@ -114,83 +194,104 @@ int HashTable::getBidKey(Bid bid) {
  * @param bidId bid id we would like to know int value for
  * @return int value of bid id
  */
-int HashTable::getStringKey(string bidId) {
-    int temp;
-    temp = stoi(bidId);
-    return temp;
+template <typename Record>
+int HashTableOf<Record>::getStringKey(string bidId) {
+    unsigned int key;
+    if (!parseKey(bidId, key)) {
+        throw invalid_argument("bid id " + bidId + " is not numeric");
+    }
+    return int(key);
+}
+
+/**
+ * Get the key of a bid id without throwing, for lookups where an id that
+ * isn't numeric simply can't be in the table
+ * @param bidId the bid id to convert
+ * @param key set to the key when the id is numeric
+ * @return false if the bid id is not numeric
+ */
+template <typename Record>
+bool HashTableOf<Record>::parseKey(const string& bidId, unsigned int& key) {
+    unsigned long long temp;
+    if (!parseUnsigned(bidId, temp) || temp > INT_MAX) {
+        return false;
+    }
+    key = (unsigned int) temp;
+    return true;
 }
+
 /**
- * Insert a bid
+ * Insert a bid, replacing any bid with the same id
  *
  * @param bid The bid to insert
  */
-void HashTable::Insert(Bid bid) {
-    // Generate the key for the hash table
-    key = getBidKey(bid);
-    key = Hash(key);
-
-    // if position is empty place the bid at key and initialize next
-    if (nodes[key].next == nullptr) {
-        Node* newNode = new Node(bid, key);
-        nodes[key] = *newNode;
-        nodes[key].next = new Node;
+template <typename Record>
+void HashTableOf<Record>::Insert(Bid bid) {
+    unsigned int key = getBidKey(bid);
+
+    int position = findSlot(key);
+    if (position >= 0) {
+        bids[slots[position].index] = packBid<Record>(move(bid));
+        return;
     }
-        // if bid already exists at position add new bid to next
-    else {
-        Node* newNode = new Node(bid, key);
-        nodes[key].next = newNode;
+
+    // double the table before it gets too full to probe quickly
+    if (bids.size() + 1 > slots.size() * maxLoadFactor) {
+        resize(slots.size() * 2);
     }
+    placeSlot(Slot{key, (unsigned int) bids.size(), 0});
+    bids.push_back(packBid<Record>(move(bid)));
 }
 
 /**
  * Print all bids
  */
-void HashTable::PrintAll() {
-    // iterate through the vector to display the bids
-    for (int i = 0; i < nodes.size(); ++i) {
-        // skip over empty nodes
-        if (nodes[i].bid.amount < 1)
+template <typename Record>
+void HashTableOf<Record>::PrintAll() {
+    // iterate through the slots to display the bids
+    for (unsigned int i = 0; i < slots.size(); ++i) {
+        // skip over empty slots
+        if (slots[i].distance == 0)
             continue;
-        // Display the bids in the vector
+        const Bid& bid = toBid(bids[slots[i].index]);
         cout << "Key " << i << ": ";
-        cout << nodes[i].bid.bidId << " | " << nodes[i].bid.title << " | ";
-        cout << nodes[i].bid.amount << " | " << nodes[i].bid.fund << endl;
-        // If any of the nodes have a chained bid due to a key collision
-        // they will be displayed here.
-        if (nodes[i].next && nodes[i].next->bid.amount > 0) {
-            cout << "    " << i << ": ";
-            cout << nodes[i].next->bid.bidId << ": " << nodes[i].next->bid.title << " | $";
-            cout << nodes[i].next->bid.amount << " | " << nodes[i].next->bid.fund << endl;
-        }
+        cout << bid.bidId << " | " << bid.title << " | ";
+        cout << bid.amount << " | " << bid.fund << endl;
     }
 }
 
 /**
- * Remove a bid
+ * Remove a bid, an id that is not numeric is not in the table
  *
  * @param bidId The bid id to search for
  */
-void HashTable::Remove(string bidId) {
-    // get the key for the bid to find
-    unsigned int temp;
-    temp = getStringKey(bidId);
-    temp = Hash(temp);
-    // if the bid is in the first position it moves the second bid
-    // to the first position overwriting the first bid
-    if (nodes[temp].bid.bidId == bidId) {
-        if (nodes[temp].next) {
-            nodes[temp] = nodes[temp].next->bid;
-            nodes[temp].next = new Node;
-        }
-            // if there is no bid in the second position it just clears the bid
-        else {
-            nodes[temp].bid.bidId = "";
-            nodes[temp].bid.amount = 0;
-        }
+template <typename Record>
+void HashTableOf<Record>::Remove(string bidId) {
+    unsigned int key;
+    int position = parseKey(bidId, key) ? findSlot(key) : -1;
+    if (position < 0) {
+        return;
+    }
+
+    // keep the bids packed by moving the last bid into the hole
+    unsigned int index = slots[position].index;
+    if (index != bids.size() - 1) {
+        bids[index] = move(bids.back());
+        slots[findSlot(getStringKey(bidIdOf(bids[index])))].index = index;
     }
-    // if the bid is in the second position it removes the bid
-    if (nodes[temp].next->bid.bidId == bidId) {
-        nodes[temp].next = new Node;
+    bids.pop_back();
+
+    // shift the following entries back a slot until one is already home
+    unsigned int hole = position;
+    while (true) {
+        unsigned int next = (hole + 1) & mask;
+        if (slots[next].distance <= 1) {
+            slots[hole].distance = 0;
+            return;
+        }
+        slots[hole] = slots[next];
+        slots[hole].distance--;
+        hole = next;
     }
 }
 
@@ -198,60 +299,112 @@ void HashTable::Remove(string bidId) {
  * Search for the specified bidId
  *
  * @param bidId The bid id to search for
+ * @return the bid, or an empty bid if it is not found or the id is not
+ *         numeric
  */
-Bid HashTable::Search(string bidId) {
-    // Calculate the key for the bid being searched
-    Bid empty;
-    unsigned int temp;
-    temp = getStringKey(bidId);
-    temp = Hash(temp);
-    // if it finds the bid in the first or second position
-    // it returns the bid if bid is not found it returns an empty bid
-    if (nodes[temp].bid.bidId == bidId) {
-        return nodes[temp].bid;
-    }
-    else if (nodes[temp].next->bid.bidId == bidId) {
-        return nodes[temp].next->bid;
+template <typename Record>
+Bid HashTableOf<Record>::Search(string bidId) {
+    unsigned int key;
+    int position = parseKey(bidId, key) ? findSlot(key) : -1;
+    if (position < 0) {
+        return Bid();
     }
-    else {
-        return empty;
+    return toBid(bids[slots[position].index]);
+}
+
+/**
+ * Search for many bid ids at once. Each group of ids goes through the
+ * table in passes so the cache misses overlap instead of each lookup
+ * waiting on the one before it: every id is hashed and its slot
+ * prefetched, then the slots are probed and the bids they point at
+ * prefetched, then the bids are copied out.
+ *
+ * @param bidIds the bid ids to search for
+ * @param count number of bid ids
+ * @param results set to the bid for each id, or an empty bid if it is
+ *                not found or not numeric
+ */
+template <typename Record>
+void HashTableOf<Record>::SearchBatch(const string* bidIds, size_t count, Bid* results) {
+    // enough lookups in flight to hide memory latency, small enough to stay on the stack
+    const size_t GROUP = 32;
+    unsigned int keys[GROUP];
+    bool numeric[GROUP];
+    int positions[GROUP];
+
+    for (size_t first = 0; first < count; first += GROUP) {
+        size_t n = min(GROUP, count - first);
+
+        for (size_t i = 0; i < n; ++i) {
+            keys[i] = 0;
+            numeric[i] = parseKey(bidIds[first + i], keys[i]);
+            __builtin_prefetch(&slots[Hash(keys[i])]);
+        }
+        for (size_t i = 0; i < n; ++i) {
+            positions[i] = numeric[i] ? findSlot(keys[i]) : -1;
+            if (positions[i] >= 0) {
+                const char* bid = reinterpret_cast<const char*>(&bids[slots[positions[i]].index]);
+                for (size_t line = 0; line < sizeof(Record); line += 64) {
+                    __builtin_prefetch(bid + line);
+                }
+            }
+        }
+        for (size_t i = 0; i < n; ++i) {
+            results[first + i] = positions[i] >= 0 ? toBid(bids[slots[positions[i]].index]) : Bid();
+        }
     }
 }
 
+/**
+ * Search for many bid ids at once
+ *
+ * @param bidIds the bid ids to search for
+ * @return the bid for each id in the same order, an empty bid for
+ *         each id that is not found
+ */
+template <typename Record>
+vector<Bid> HashTableOf<Record>::SearchBatch(const vector<string>& bidIds) {
+    vector<Bid> results(bidIds.size());
+    SearchBatch(bidIds.data(), bidIds.size(), results.data());
+    return results;
+}
+
 /**
  * Load a CSV file containing bids into a container
  *
  * @param csvPath the path to the CSV file to load
- * @return an int of the number of bids inserted ot the hash table
+ * @return the number of bids added to the hash table, a bid replacing
+ *         one with the same id is not counted
  */
-int HashTable::loadBids(string csvPath, HashTable* hashTable) {
-    int numBids = 0;
+template <typename Record>
+int HashTableOf<Record>::loadBids(string csvPath, HashTableOf* hashTable) {
+    unsigned int initial = hashTable->Count();
 
-    // initialize the CSV Parser using the given path
-    csv::Parser file = csv::Parser(csvPath);
+    // initialize the CSV Reader, rows are parsed one at a time as they are loaded
+    // and only the bid columns are kept
+    csv::Reader file = csv::Reader(csvPath, csv::eMMAP, ',', BID_COLUMNS);
 
     try {
         // loop to read rows of a CSV file
-        for (unsigned int i = 0; i < file.rowCount(); i++) {
+        while (file.next()) {
 
             // Create a data structure and add to the collection of bids
             Bid bid;
-            bid.bidId = file[i][1];
-            bid.title = file[i][0];
-            bid.fund = file[i][19];
-            bid.datePaid = file[i][10];
-            bid.receiptNumber = file[i][15];
-            bid.netSales = strToDouble(file[i][18],'$');
-            bid.amount = strToDouble(file[i][4], '$');
-
-            numBids++;
+            bid.bidId = string(file[BID_ID]);
+            bid.title = string(file[TITLE]);
+            bid.fund = string(file[FUND]);
+            bid.datePaid = string(file[DATE_PAID]);
+            bid.receiptNumber = string(file[RECEIPT_NUMBER]);
+            bid.netSales = currencyToDouble(file[NET_SALES]);
+            bid.amount = currencyToDouble(file[AMOUNT]);
+
             // push this bid to the end
-            hashTable->Insert(bid);
+            hashTable->Insert(move(bid));
         }
     } catch (csv::Error &e) {
         cerr << e.what() << endl;
     }
-    return numBids;
+    return hashTable->Count() - initial;
 }
 
 /**
@@ -259,11 +412,23 @@ int HashTable::loadBids(string csvPath, HashTable* hashTable) {
  * from the CSV
  * @return false if bids have been loaded and true if table is empty
  */
-bool HashTable::Size() {
-    if (nodes[9185].bid.bidId == "98880"){
-        return false;
-    }
-    else {
-        return true;
-    }
+template <typename Record>
+bool HashTableOf<Record>::Size() {
+    return bids.empty();
+}
+
+/**
+ * Number of bids in the table
+ */
+template <typename Record>
+unsigned int HashTableOf<Record>::Count() const {
+    return bids.size();
+}
+
+/**
+ * Number of slots in the table
+ */
+template <typename Record>
+unsigned int HashTableOf<Record>::Capacity() const {
+    return slots.size();
 }
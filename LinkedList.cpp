@@ -5,9 +5,13 @@
 #include <algorithm>
 #include <iostream>
 #include <time.h>
+#include <atomic>
 #include <climits>
+#include <cmath>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <cstring>
 
 #include "CSVparser.hpp"
 
@@ -25,8 +29,91 @@ struct Bid {
     Bid() {
         amount = 0.0;
     }
+    Bid(const Bid& other);
+    Bid(Bid&& other) = default;
+    Bid& operator=(const Bid& other);
+    Bid& operator=(Bid&& other) = default;
+    // number of bids copied, moves are free so loads should not add to it
+    static atomic<size_t> copies;
 };
 
+atomic<size_t> Bid::copies(0);
+
+/**
+ * Copy constructor, counted
+ */
+Bid::Bid(const Bid& other) : bidId(other.bidId), title(other.title), fund(other.fund),
+        datePaid(other.datePaid), receiptNumber(other.receiptNumber), netSales(other.netSales),
+        amount(other.amount) {
+    copies.fetch_add(1, memory_order_relaxed);
+}
+
+/**
+ * Copy assignment, counted
+ */
+Bid& Bid::operator=(const Bid& other) {
+    bidId = other.bidId;
+    title = other.title;
+    fund = other.fund;
+    datePaid = other.datePaid;
+    receiptNumber = other.receiptNumber;
+    netSales = other.netSales;
+    amount = other.amount;
+    copies.fetch_add(1, memory_order_relaxed);
+    return *this;
+}
+
+//============================================================================
+// Bid records
+//============================================================================
+
+/**
+ * The containers keep their bids as a Record, either Bid itself or the
+ * CompactBid of CompactBid.cpp, while still taking and handing back Bid.
+ * These are the few things a container needs from a record, overloaded
+ * for each form; for Bid each one passes the bid straight through.
+ */
+template <typename Record>
+Record packBid(Bid bid);
+
+/**
+ * Turn a bid into the record a container keeps
+ */
+template <>
+Bid packBid<Bid>(Bid bid) {
+    return bid;
+}
+
+/**
+ * The bid a record holds
+ */
+const Bid& toBid(const Bid& bid) {
+    return bid;
+}
+
+/**
+ * Bid id of a record
+ */
+const string& bidIdOf(const Bid& bid) {
+    return bid.bidId;
+}
+
+/**
+ * Winning bid of a record in cents
+ */
+long long amountCentsOf(const Bid& bid) {
+    return llround(bid.amount * 100);
+}
+
+// Columns of the bid export read by every loader, in the order of
+// BID_COLUMNS so they can index a projected row
+enum BidColumn {
+    TITLE, BID_ID, AMOUNT, DATE_PAID, RECEIPT_NUMBER, NET_SALES, FUND
+};
+const csv::Projection BID_COLUMNS(vector<string>{
+    "Auction Title", "Auction ID", "Winning Bid", "Paid Date", "Receipt Number", "Net Sales", "Fund"
+});
+
 /**
 * Simple C function to convert a string to a double
 * after stripping out unwanted char
@@ -40,25 +127,149 @@ double strToDouble(string str, char ch) {
     return atof(str.c_str());
 }
 
+/**
+ * Same conversion for a field viewed straight out of a mapped CSV,
+ * stripping into a stack buffer instead of a temporary string
+ *
+ * @param ch The character to strip out
+ */
+double strToDouble(string_view str, char ch) {
+    char buffer[64];
+    if (str.size() >= sizeof(buffer)) {
+        return strToDouble(string(str), ch);
+    }
+    size_t length = 0;
+    for (char c : str) {
+        if (c != ch) {
+            buffer[length++] = c;
+        }
+    }
+    buffer[length] = '\0';
+    return atof(buffer);
+}
+
+/**
+ * Parse a currency value such as "$1,234.56" or "$-132.68" into integer
+ * cents without allocating. Group separators are skipped and digits past
+ * the cents are rounded half away from zero.
+ *
+ * @param text the value to parse
+ * @param cents set to the value in cents when the text is a currency value
+ * @return false if the text is not a currency value
+ */
+bool parseCents(string_view text, long long& cents) {
+    size_t i = 0;
+    bool negative = false;
+
+    // sign and dollar sign may come in either order
+    for (int prefix = 0; prefix < 2 && i < text.size(); ++prefix) {
+        if (text[i] == '$') {
+            ++i;
+        } else if (text[i] == '-' && !negative) {
+            negative = true;
+            ++i;
+        }
+    }
+
+    long long value = 0;
+    int digits = 0;
+    for (; i < text.size() && (isdigit((unsigned char) text[i]) || text[i] == ','); ++i) {
+        if (text[i] != ',') {
+            if (value > (LLONG_MAX - 9) / 1000) {
+                return false;
+            }
+            value = value * 10 + (text[i] - '0');
+            ++digits;
+        }
+    }
+    value *= 100;
+
+    if (i < text.size() && text[i] == '.') {
+        ++i;
+        int decimals = 0;
+        for (; i < text.size() && isdigit((unsigned char) text[i]); ++i, ++decimals) {
+            if (decimals == 0) {
+                value += (text[i] - '0') * 10;
+            } else if (decimals == 1) {
+                value += text[i] - '0';
+            } else if (decimals == 2 && text[i] >= '5') {
+                ++value;
+            }
+        }
+        digits += decimals;
+    }
+
+    if (digits == 0 || i != text.size()) {
+        return false;
+    }
+    cents = negative ? -value : value;
+    return true;
+}
+
+/**
+ * Parse a numeric id such as a bid id or receipt number without allocating
+ *
+ * @param text the value to parse, digits only
+ * @param value set to the number when the text is numeric
+ * @return false if the text is empty, not numeric or too large
+ */
+bool parseUnsigned(string_view text, unsigned long long& value) {
+    if (text.empty()) {
+        return false;
+    }
+    unsigned long long result = 0;
+    for (char c : text) {
+        if (!isdigit((unsigned char) c) || result > (ULLONG_MAX - 9) / 10) {
+            return false;
+        }
+        result = result * 10 + (c - '0');
+    }
+    value = result;
+    return true;
+}
+
+/**
+ * Convert a currency field to a double through the integer cents parser,
+ * falling back to strToDouble for anything it doesn't accept. Cents divided
+ * by 100 round to the same double atof gives for up to two decimals.
+ *
+ * @param text the value to convert
+ */
+double currencyToDouble(string_view text) {
+    long long cents;
+    if (parseCents(text, cents)) {
+        return cents / 100.0;
+    }
+    return strToDouble(text, '$');
+}
+
 //============================================================================
 // Linked List Class Definition
 //============================================================================
 
-
-class LinkedList {
+/**
+ * Class containing data members and methods to implement an unrolled
+ * linked list: each node holds a block of bids, so walking the list
+ * reads bids that sit next to each other in memory and there is one
+ * allocation per block instead of one per bid. The list keeps a pointer
+ * to its last node and a count of its bids, so appending and asking
+ * for the size don't walk the list. The blocks come from a NodePool.
+ * Bids are kept as Record, Bid or CompactBid.
+ */
+template <typename Record>
+class LinkedListOf {
 
 private:
+    static const unsigned int BLOCK_SIZE = 16;
+
     // Internal structure for list entries, housekeeping variables
     struct Node {
-        Bid bid;
+        Record bids[BLOCK_SIZE];
+        unsigned int count;
         Node *next;
 
         Node() {
-            next = nullptr;
-        }
-
-        Node(Bid aBid) {
-            bid = aBid;
+            count = 0;
             next = nullptr;
         }
     };
@@ -66,82 +277,100 @@ private:
     int size;
     Node *head;
     Node *tail;
-
-
+    NodePool<Node> pool;
 
 public:
-    LinkedList();
-    virtual ~LinkedList();
+    LinkedListOf();
+    virtual ~LinkedListOf();
+    LinkedListOf(const LinkedListOf&) = delete;
+    LinkedListOf& operator=(const LinkedListOf&) = delete;
     void Append(Bid bid);
     void Prepend(Bid bid);
     void PrintList();
     void Remove(string bidId);
     Bid Search(string bidId);
     int Size();
-    static void loadBids(string, LinkedList*);
+    static void loadBids(string, LinkedListOf*);
 };
 
+using LinkedList = LinkedListOf<Bid>;
+
 /**
 * Default constructor
 */
-LinkedList::LinkedList() {
+template <typename Record>
+LinkedListOf<Record>::LinkedListOf() {
     // housekeeping variables
     head = NULL;
     tail = NULL;
     size = 0;
-
 }
 
 /**
  * Destructor
  */
-LinkedList::~LinkedList() {
+template <typename Record>
+LinkedListOf<Record>::~LinkedListOf() {
+    while (head != NULL) {
+        Node *next = head->next;
+        pool.Delete(head);
+        head = next;
+    }
 }
 
 /**
  * Append a new bid to the end of the list
  * @param bid bid to be inserted at end of linked list
  */
-void LinkedList::Append(Bid bid) {
-    // append logic
-    // Check to see if list is empty
-    if (head == NULL)
-        head = new Node(bid);
-        // Itterate through the list to find the end
-    else {
-        Node *nodePointer = new Node;
-        nodePointer = head;
-
-        while (nodePointer->next != NULL) {
-            nodePointer = nodePointer->next;
+template <typename Record>
+void LinkedListOf<Record>::Append(Bid bid) {
+    // start a new block when the list is empty or the last block is full
+    if (tail == NULL || tail->count == BLOCK_SIZE) {
+        Node *node = pool.New();
+        if (tail == NULL) {
+            head = node;
+        } else {
+            tail->next = node;
         }
-
-        // Add new Node to end of list
-        nodePointer->next = new Node(bid);
+        tail = node;
     }
+    tail->bids[tail->count++] = packBid<Record>(move(bid));
+    size++;
 }
 
 /**
  * Prepend a new bid to the start of the list
  * @param bid the bid to be inserted at front of linked list
  */
-void LinkedList::Prepend(Bid bid) {
-    Node *nodePointer = new Node;
-    nodePointer->bid = bid;
-    nodePointer->next = head;
-    head = nodePointer;
+template <typename Record>
+void LinkedListOf<Record>::Prepend(Bid bid) {
+    // start a new block when the list is empty or the first block is full
+    if (head == NULL || head->count == BLOCK_SIZE) {
+        Node *node = pool.New();
+        node->next = head;
+        head = node;
+        if (tail == NULL) {
+            tail = node;
+        }
+    }
+    // make room at the front of the first block
+    move_backward(head->bids, head->bids + head->count, head->bids + head->count + 1);
+    head->bids[0] = packBid<Record>(move(bid));
+    head->count++;
+    size++;
 }
 
 /**
  * Simplified output of all bids in the list
  */
-void LinkedList::PrintList() {
-    Node *nodePointer = head;
-
-    while (nodePointer) {
-        cout << nodePointer->bid.bidId << ": ";
-        cout << nodePointer->bid.title << " | " << nodePointer->bid.amount << " | " << nodePointer->bid.fund << endl;
-        nodePointer = nodePointer->next;
+template <typename Record>
+void LinkedListOf<Record>::PrintList() {
+    for (Node *node = head; node != NULL; node = node->next) {
+        for (unsigned int i = 0; i < node->count; ++i) {
+            const Bid& bid = toBid(node->bids[i]);
+            cout << bid.bidId << ": ";
+            cout << bid.title << " | " << bid.amount << " | " << bid.fund << endl;
+        }
     }
 }
 
@@ -150,98 +379,101 @@ void LinkedList::PrintList() {
  *
  * @param bidId The bid id to remove from the list
  */
-void LinkedList::Remove(string bidId) {
-    Node *nodePointer, *previousNode;
-    if (head->bid.bidId == bidId) {
-        nodePointer = head;
-        head = head->next;
-        delete nodePointer;
-    }
-    else {
-        nodePointer = head;
-        while (nodePointer != NULL && nodePointer->bid.bidId != bidId) {
-            previousNode = nodePointer;
-            nodePointer = nodePointer->next;
-        }
-        if (nodePointer) {
-            previousNode->next = nodePointer->next;
-            delete nodePointer;
+template <typename Record>
+void LinkedListOf<Record>::Remove(string bidId) {
+    Node *previousNode = NULL;
+    for (Node *node = head; node != NULL; previousNode = node, node = node->next) {
+        for (unsigned int i = 0; i < node->count; ++i) {
+            if (bidIdOf(node->bids[i]) != bidId) {
+                continue;
+            }
+
+            // close the gap in the block
+            move(node->bids + i + 1, node->bids + node->count, node->bids + i);
+            node->count--;
+            node->bids[node->count] = Record();
+            size--;
+
+            if (node->count == 0) {
+                // unlink a block that is now empty
+                if (previousNode == NULL) {
+                    head = node->next;
+                } else {
+                    previousNode->next = node->next;
+                }
+                if (tail == node) {
+                    tail = previousNode;
+                }
+                pool.Delete(node);
+            } else if (node->next != NULL && node->count + node->next->count <= BLOCK_SIZE / 2) {
+                // fold a nearly empty neighbour in so blocks stay well filled
+                Node *next = node->next;
+                move(next->bids, next->bids + next->count, node->bids + node->count);
+                node->count += next->count;
+                node->next = next->next;
+                if (tail == next) {
+                    tail = node;
+                }
+                pool.Delete(next);
+            }
+            return;
         }
     }
-
-
 }
 
 /**
  * Search for the specified bidId
  *
  * @param bidId The bid id to search for
+ * @return the bid, or an empty bid if it is not found
  */
-Bid LinkedList::Search(string bidId) {
-    Bid bid;
-
-    Node *nodePointer, *previousNode;
-    if (head->bid.bidId == bidId) {
-        cout << head->bid.bidId << ": " << head->bid.title << " | ";
-        cout << head->bid.amount << " | " << head->bid.fund<< endl;
-        return nodePointer->bid;
-    }
-    else {
-        nodePointer = head;
-        while (nodePointer != NULL && nodePointer->bid.bidId != bidId) {
-            previousNode = nodePointer;
-            nodePointer = nodePointer->next;
-        }
-        if (nodePointer) {
-            return nodePointer->bid;
-        }
-        else {
-            return bid;
+template <typename Record>
+Bid LinkedListOf<Record>::Search(string bidId) {
+    for (Node *node = head; node != NULL; node = node->next) {
+        for (unsigned int i = 0; i < node->count; ++i) {
+            if (bidIdOf(node->bids[i]) == bidId) {
+                return toBid(node->bids[i]);
+            }
         }
     }
+    return Bid();
 }
 
 /**
  * Returns the current size (number of elements) in the list
  */
-int LinkedList::Size() {
-    int size = 0;
-    Node *nodePointer = new Node;
-    nodePointer = head;
-    while (nodePointer != NULL) {
-        size++;
-        nodePointer = nodePointer->next;
-    }
+template <typename Record>
+int LinkedListOf<Record>::Size() {
     return size;
 }
 
-
-
 /**
  * Load a CSV file containing bids into a LinkedList
  *
  * @return a LinkedList containing all the bids read
  */
-void LinkedList::loadBids(string csvPath, LinkedList *list) {
-    // initialize the CSV Parser
-    csv::Parser file = csv::Parser(csvPath);
+template <typename Record>
+void LinkedListOf<Record>::loadBids(string csvPath, LinkedListOf *list) {
+    // initialize the CSV Reader, rows are parsed one at a time as they are loaded
+    // and only the bid columns are kept
+    csv::Reader file = csv::Reader(csvPath, csv::eMMAP, ',', BID_COLUMNS);
 
     try {
         // loop to read rows of a CSV file
-        for (int i = 0; i < file.rowCount(); i++) {
+        while (file.next()) {
 
-            // initialize a bid using data from current row (i)
+            // initialize a bid using data from current row
             Bid bid;
-            bid.bidId = file[i][1];
-            bid.title = file[i][0];
-            bid.fund = file[i][19];
-            bid.datePaid = file[i][10];
-            bid.receiptNumber = file[i][15];
-            bid.netSales = strToDouble(file[i][18],'$');
-            bid.amount = strToDouble(file[i][4], '$');
+            bid.bidId = string(file[BID_ID]);
+            bid.title = string(file[TITLE]);
+            bid.fund = string(file[FUND]);
+            bid.datePaid = string(file[DATE_PAID]);
+            bid.receiptNumber = string(file[RECEIPT_NUMBER]);
+            bid.netSales = currencyToDouble(file[NET_SALES]);
+            bid.amount = currencyToDouble(file[AMOUNT]);
 
             // add this bid to the end
-            list->Append(bid);
+            list->Append(move(bid));
         }
     } catch (csv::Error &e) {
         cerr << e.what() << endl;
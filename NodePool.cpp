@@ -0,0 +1,188 @@
+//
+// Slab allocator for the nodes of the node based containers
+//
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+//============================================================================
+// Node Pool class definition
+//============================================================================
+
+/**
+ * Counters shared by every node pool, so the benchmarks can show how many
+ * times the containers went to the heap
+ */
+struct NodePoolCounters {
+    // pools made while this is false pass every node straight to the heap
+    static bool enabled;
+    static atomic<size_t> heapAllocations;
+    static atomic<size_t> nodes;
+};
+
+bool NodePoolCounters::enabled = true;
+atomic<size_t> NodePoolCounters::heapAllocations(0);
+atomic<size_t> NodePoolCounters::nodes(0);
+
+/**
+ * Class that hands out memory for one type of node from large contiguous
+ * slabs instead of a heap allocation per node. Freed nodes go on a free
+ * list and are handed out again first. Every slab is released at once
+ * when the pool is destroyed, so the container owning the pool only has
+ * to destroy its nodes, not free them one by one.
+ *
+ * A pool is used by one thread at a time, like the container it serves.
+ * HashTable has no pool: since its Robin Hood rewrite it keeps its bids
+ * in one vector and has no nodes to allocate.
+ */
+template <typename T>
+class NodePool {
+
+private:
+    union Slot {
+        Slot* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    // slabs of about 64 KB, at least 16 nodes each
+    static const size_t SLAB_SIZE = max<size_t>(16, 65536 / sizeof(Slot));
+    vector<unique_ptr<Slot[]>> slabs;
+    Slot* freeList;
+    size_t used;
+    bool pooled;
+    size_t allocations;
+    size_t frees;
+    void* allocate();
+    void release(void* memory);
+
+public:
+    NodePool();
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+    template <typename... Args> T* New(Args&&... args);
+    void Delete(T* node);
+    size_t Allocations() const;
+    size_t Live() const;
+    size_t Slabs() const;
+    size_t Bytes() const;
+};
+
+/**
+ * Default constructor, the pool is only used if pools are enabled when
+ * it is made
+ */
+template <typename T>
+NodePool<T>::NodePool() {
+    freeList = nullptr;
+    used = SLAB_SIZE;
+    pooled = NodePoolCounters::enabled;
+    allocations = 0;
+    frees = 0;
+}
+
+/**
+ * Take memory for a node from the free list or the current slab,
+ * starting a new slab when it is used up
+ */
+template <typename T>
+void* NodePool<T>::allocate() {
+    NodePoolCounters::nodes.fetch_add(1, memory_order_relaxed);
+    if (!pooled) {
+        NodePoolCounters::heapAllocations.fetch_add(1, memory_order_relaxed);
+        return ::operator new(sizeof(T));
+    }
+    if (freeList != nullptr) {
+        Slot* slot = freeList;
+        freeList = slot->next;
+        return slot;
+    }
+    if (used == SLAB_SIZE) {
+        NodePoolCounters::heapAllocations.fetch_add(1, memory_order_relaxed);
+        slabs.emplace_back(new Slot[SLAB_SIZE]);
+        used = 0;
+    }
+    return &slabs.back()[used++];
+}
+
+/**
+ * Give the memory of a destroyed node back to the pool
+ */
+template <typename T>
+void NodePool<T>::release(void* memory) {
+    if (!pooled) {
+        ::operator delete(memory);
+        return;
+    }
+    Slot* slot = static_cast<Slot*>(memory);
+    slot->next = freeList;
+    freeList = slot;
+}
+
+/**
+ * Make a node in memory from the pool
+ * @param args arguments for the node's constructor
+ * @return the new node
+ */
+template <typename T>
+template <typename... Args>
+T* NodePool<T>::New(Args&&... args) {
+    void* memory = allocate();
+    try {
+        T* node = new (memory) T(forward<Args>(args)...);
+        allocations++;
+        return node;
+    } catch (...) {
+        release(memory);
+        throw;
+    }
+}
+
+/**
+ * Destroy a node made by this pool and keep its memory for the next one
+ * @param node the node to destroy
+ */
+template <typename T>
+void NodePool<T>::Delete(T* node) {
+    node->~T();
+    release(node);
+    frees++;
+}
+
+/**
+ * Number of nodes made by the pool
+ */
+template <typename T>
+size_t NodePool<T>::Allocations() const {
+    return allocations;
+}
+
+/**
+ * Number of nodes made by the pool and not yet deleted
+ */
+template <typename T>
+size_t NodePool<T>::Live() const {
+    return allocations - frees;
+}
+
+/**
+ * Number of slabs the pool holds
+ */
+template <typename T>
+size_t NodePool<T>::Slabs() const {
+    return slabs.size();
+}
+
+/**
+ * Memory held in slabs
+ */
+template <typename T>
+size_t NodePool<T>::Bytes() const {
+    return slabs.size() * SLAB_SIZE * sizeof(Slot);
+}
@@ -0,0 +1,445 @@
+//
+// Order statistics of bids by winning bid amount
+//
+
+#include <algorithm>
+#include <iostream>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#include <string>
+
+#include "CSVparser.hpp"
+
+using namespace std;
+
+//============================================================================
+// Order Statistic Tree class definition
+//============================================================================
+
+/**
+ * Class containing data members and methods to implement a balanced
+ * (AVL) tree of bids ordered by winning bid amount, where every node also
+ * keeps the number of bids below it and the total of their amounts. That
+ * lets rank, select, percentile and running total queries be answered by
+ * walking a single path from the root instead of sorting all the bids.
+ *
+ * Totals are kept in cents so they never drift as bids are added, and
+ * bids are kept as Record, Bid or CompactBid. Each bid id is counted
+ * once: a bid whose id is already in the tree replaces the earlier one,
+ * as it would in the hash table, so the same bid added through several
+ * containers is not counted twice.
+ */
+template <typename Record>
+class OrderStatisticTreeOf {
+
+private:
+    struct Node {
+        Record bid;
+        long long cents;
+        Node* left;
+        Node* right;
+        int height;
+        // bids and total cents in the subtree rooted here
+        unsigned int size;
+        long long sum;
+        Node(Bid abid) {
+            this->bid = packBid<Record>(move(abid));
+            this->cents = amountCentsOf(this->bid);
+            this->left = nullptr;
+            this->right = nullptr;
+            this->height = 1;
+            this->size = 1;
+            this->sum = cents;
+        }
+    };
+
+    static const int MAX_HEIGHT = 64;
+    Node* root;
+    NodePool<Node> pool;
+    // cents of the bid counted for each id
+    unordered_map<string, long long> counted;
+    static bool before(long long cents, const string& bidId, const Node* node);
+    static int height(Node* node);
+    static unsigned int size(Node* node);
+    static long long sum(Node* node);
+    static void update(Node* node);
+    static Node* rotateLeft(Node* node);
+    static Node* rotateRight(Node* node);
+    static Node* rebalance(Node* node);
+    static Node* takeSmallest(Node* node, Node** smallest);
+    Node* erase(Node* node, long long cents, const string& bidId);
+
+public:
+    OrderStatisticTreeOf();
+    virtual ~OrderStatisticTreeOf();
+    OrderStatisticTreeOf(const OrderStatisticTreeOf&) = delete;
+    OrderStatisticTreeOf& operator=(const OrderStatisticTreeOf&) = delete;
+    void Insert(Bid bid);
+    unsigned int Count() const;
+    unsigned int Rank(double amount) const;
+    Bid Select(unsigned int k) const;
+    Bid SelectLargest(unsigned int k) const;
+    Bid Percentile(double percent) const;
+    double PrefixSum(double amount) const;
+    double Total() const;
+    static int loadBids(string, OrderStatisticTreeOf*);
+};
+
+using OrderStatisticTree = OrderStatisticTreeOf<Bid>;
+
+/**
+ * Default constructor
+ */
+template <typename Record>
+OrderStatisticTreeOf<Record>::OrderStatisticTreeOf() {
+    root = nullptr;
+}
+
+/**
+ * Destructor
+ */
+template <typename Record>
+OrderStatisticTreeOf<Record>::~OrderStatisticTreeOf() {
+    // free the nodes without recursion by rotating left children up
+    // until each node has none, then stepping right
+    while (root != nullptr) {
+        if (root->left != nullptr) {
+            Node* left = root->left;
+            root->left = left->right;
+            left->right = root;
+            root = left;
+        } else {
+            Node* right = root->right;
+            pool.Delete(root);
+            root = right;
+        }
+    }
+}
+
+/**
+ * Height of a subtree, 0 for an empty one
+ */
+template <typename Record>
+int OrderStatisticTreeOf<Record>::height(Node* node) {
+    return node == nullptr ? 0 : node->height;
+}
+
+/**
+ * Number of bids in a subtree
+ */
+template <typename Record>
+unsigned int OrderStatisticTreeOf<Record>::size(Node* node) {
+    return node == nullptr ? 0 : node->size;
+}
+
+/**
+ * Total cents of the bids in a subtree
+ */
+template <typename Record>
+long long OrderStatisticTreeOf<Record>::sum(Node* node) {
+    return node == nullptr ? 0 : node->sum;
+}
+
+/**
+ * Recompute the height, size and total of a node from its children
+ */
+template <typename Record>
+void OrderStatisticTreeOf<Record>::update(Node* node) {
+    node->height = 1 + max(height(node->left), height(node->right));
+    node->size = 1 + size(node->left) + size(node->right);
+    node->sum = node->cents + sum(node->left) + sum(node->right);
+}
+
+/**
+ * Rotate a subtree left, its right child becomes its root
+ * @param node root of the subtree
+ * @return the new root of the subtree
+ */
+template <typename Record>
+typename OrderStatisticTreeOf<Record>::Node* OrderStatisticTreeOf<Record>::rotateLeft(Node* node) {
+    Node* right = node->right;
+    node->right = right->left;
+    right->left = node;
+    update(node);
+    update(right);
+    return right;
+}
+
+/**
+ * Rotate a subtree right, its left child becomes its root
+ * @param node root of the subtree
+ * @return the new root of the subtree
+ */
+template <typename Record>
+typename OrderStatisticTreeOf<Record>::Node* OrderStatisticTreeOf<Record>::rotateRight(Node* node) {
+    Node* left = node->left;
+    node->left = left->right;
+    left->right = node;
+    update(node);
+    update(left);
+    return left;
+}
+
+/**
+ * Restore the AVL balance of a subtree whose children differ in height
+ * by at most two
+ * @param node root of the subtree
+ * @return the new root of the subtree
+ */
+template <typename Record>
+typename OrderStatisticTreeOf<Record>::Node* OrderStatisticTreeOf<Record>::rebalance(Node* node) {
+    update(node);
+    int balance = height(node->left) - height(node->right);
+    if (balance > 1) {
+        if (height(node->left->left) < height(node->left->right)) {
+            node->left = rotateLeft(node->left);
+        }
+        return rotateRight(node);
+    }
+    if (balance < -1) {
+        if (height(node->right->right) < height(node->right->left)) {
+            node->right = rotateRight(node->right);
+        }
+        return rotateLeft(node);
+    }
+    return node;
+}
+
+/**
+ * Whether a bid goes before a node, bids are ordered by amount and then
+ * by id so every bid has one place in the tree
+ */
+template <typename Record>
+bool OrderStatisticTreeOf<Record>::before(long long cents, const string& bidId, const Node* node) {
+    return cents != node->cents ? cents < node->cents : bidId < bidIdOf(node->bid);
+}
+
+/**
+ * Unlink the smallest bid of a subtree
+ * @param node root of the subtree
+ * @param smallest set to the unlinked node
+ * @return the new root of the subtree
+ */
+template <typename Record>
+typename OrderStatisticTreeOf<Record>::Node* OrderStatisticTreeOf<Record>::takeSmallest(
+        Node* node, Node** smallest) {
+    if (node->left == nullptr) {
+        *smallest = node;
+        return node->right;
+    }
+    node->left = takeSmallest(node->left, smallest);
+    return rebalance(node);
+}
+
+/**
+ * Remove a bid from a subtree, the depth is bounded by the tree height
+ * @param node root of the subtree
+ * @param cents winning bid of the bid to remove
+ * @param bidId id of the bid to remove
+ * @return the new root of the subtree
+ */
+template <typename Record>
+typename OrderStatisticTreeOf<Record>::Node* OrderStatisticTreeOf<Record>::erase(
+        Node* node, long long cents, const string& bidId) {
+    if (node == nullptr) {
+        return nullptr;
+    }
+    if (before(cents, bidId, node)) {
+        node->left = erase(node->left, cents, bidId);
+    } else if (cents != node->cents || bidId != bidIdOf(node->bid)) {
+        node->right = erase(node->right, cents, bidId);
+    } else {
+        Node* left = node->left;
+        Node* right = node->right;
+        pool.Delete(node);
+        if (right == nullptr) {
+            return left;
+        }
+        // the smallest bid on the right takes the removed bid's place
+        right = takeSmallest(right, &node);
+        node->left = left;
+        node->right = right;
+    }
+    return rebalance(node);
+}
+
+/**
+ * Insert a bid, replacing the bid counted for its id if there is one
+ * @param bid the bid to be inserted
+ */
+template <typename Record>
+void OrderStatisticTreeOf<Record>::Insert(Bid bid) {
+    long long cents = llround(bid.amount * 100);
+    auto found = counted.find(bid.bidId);
+    if (found != counted.end()) {
+        root = erase(root, found->second, bid.bidId);
+        found->second = cents;
+    } else {
+        counted.emplace(bid.bidId, cents);
+    }
+    Node* node = pool.New(move(bid));
+
+    // links followed from the root down to where the bid goes
+    Node** path[MAX_HEIGHT];
+    int depth = 0;
+    Node** link = &root;
+    while (*link != nullptr) {
+        path[depth++] = link;
+        link = before(node->cents, bidIdOf(node->bid), *link) ? &(*link)->left : &(*link)->right;
+    }
+    *link = node;
+
+    // every subtree on the path gained a bid, so all of them are updated
+    while (depth > 0) {
+        Node** parent = path[--depth];
+        *parent = rebalance(*parent);
+    }
+}
+
+/**
+ * Number of bids in the tree
+ */
+template <typename Record>
+unsigned int OrderStatisticTreeOf<Record>::Count() const {
+    return size(root);
+}
+
+/**
+ * Number of bids with a winning bid below an amount
+ * @param amount the amount to rank
+ */
+template <typename Record>
+unsigned int OrderStatisticTreeOf<Record>::Rank(double amount) const {
+    long long cents = llround(amount * 100);
+    unsigned int rank = 0;
+    for (Node* node = root; node != nullptr; ) {
+        if (node->cents < cents) {
+            rank += size(node->left) + 1;
+            node = node->right;
+        } else {
+            node = node->left;
+        }
+    }
+    return rank;
+}
+
+/**
+ * Find the bid with the k-th smallest winning bid
+ * @param k position counting from 0 for the smallest
+ * @return the bid at that position
+ * @throws out_of_range if there are not more than k bids
+ */
+template <typename Record>
+Bid OrderStatisticTreeOf<Record>::Select(unsigned int k) const {
+    if (k >= Count()) {
+        throw out_of_range("OrderStatisticTree : no bid at position " + to_string(k));
+    }
+    Node* node = root;
+    while (true) {
+        unsigned int left = size(node->left);
+        if (k < left) {
+            node = node->left;
+        } else if (k == left) {
+            return toBid(node->bid);
+        } else {
+            k -= left + 1;
+            node = node->right;
+        }
+    }
+}
+
+/**
+ * Find the bid with the k-th largest winning bid
+ * @param k position counting from 0 for the largest
+ * @return the bid at that position
+ * @throws out_of_range if there are not more than k bids
+ */
+template <typename Record>
+Bid OrderStatisticTreeOf<Record>::SelectLargest(unsigned int k) const {
+    if (k >= Count()) {
+        throw out_of_range("OrderStatisticTree : no bid at position " + to_string(k));
+    }
+    return Select(Count() - 1 - k);
+}
+
+/**
+ * Find the bid at a percentile of winning bids, by nearest rank
+ * @param percent the percentile, from 0 to 100
+ * @return the smallest bid with at least that percent of bids at or below it
+ * @throws out_of_range if the tree is empty
+ */
+template <typename Record>
+Bid OrderStatisticTreeOf<Record>::Percentile(double percent) const {
+    unsigned int n = Count();
+    double rank = ceil(percent / 100 * n);
+    unsigned int k = rank < 1 ? 0 : min((unsigned int) rank, n) - 1;
+    return Select(k);
+}
+
+/**
+ * Total of the winning bids below an amount
+ * @param amount the amount to total up to
+ */
+template <typename Record>
+double OrderStatisticTreeOf<Record>::PrefixSum(double amount) const {
+    long long cents = llround(amount * 100);
+    long long total = 0;
+    for (Node* node = root; node != nullptr; ) {
+        if (node->cents < cents) {
+            total += sum(node->left) + node->cents;
+            node = node->right;
+        } else {
+            node = node->left;
+        }
+    }
+    return total / 100.0;
+}
+
+/**
+ * Total of all the winning bids
+ */
+template <typename Record>
+double OrderStatisticTreeOf<Record>::Total() const {
+    return sum(root) / 100.0;
+}
+
+/**
+ * Load a CSV file containing bids into a container
+ *
+ * @param csvPath the path to the CSV file to load
+ * @param tree the tree to add the bids to
+ * @return the number of bids added, a bid replacing one with the same id
+ *         is not counted
+ */
+template <typename Record>
+int OrderStatisticTreeOf<Record>::loadBids(string csvPath, OrderStatisticTreeOf* tree) {
+    unsigned int initial = tree->Count();
+
+    // initialize the CSV Reader, rows are parsed one at a time as they are loaded
+    // and only the bid columns are kept
+    csv::Reader file = csv::Reader(csvPath, csv::eMMAP, ',', BID_COLUMNS);
+
+    try {
+        // loop to read rows of a CSV file
+        while (file.next()) {
+
+            // Create a data structure and add to the collection of bids
+            Bid bid;
+            bid.bidId = string(file[BID_ID]);
+            bid.title = string(file[TITLE]);
+            bid.fund = string(file[FUND]);
+            bid.datePaid = string(file[DATE_PAID]);
+            bid.receiptNumber = string(file[RECEIPT_NUMBER]);
+            bid.netSales = currencyToDouble(file[NET_SALES]);
+            bid.amount = currencyToDouble(file[AMOUNT]);
+
+            // push this bid to the end
+            tree->Insert(move(bid));
+        }
+    } catch (csv::Error &e) {
+        cerr << e.what() << endl;
+    }
+    return tree->Count() - initial;
+}
@@ -0,0 +1,125 @@
+//
+// Orderings of bids on several fields, put together at compile time
+//
+
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+//============================================================================
+// Bid fields
+//============================================================================
+
+/**
+ * Compare two values, negative if the first goes first, 0 if they are the
+ * same and positive if the second goes first
+ */
+template <typename T>
+int threeWay(const T& a, const T& b) {
+    return (b < a) - (a < b);
+}
+
+/**
+ * Bid ids compared as numbers, ids are numeric so a shorter id is a
+ * smaller number and ids of the same length compare as text
+ */
+struct BidIdField {
+    static int compare(const Bid& a, const Bid& b) {
+        if (a.bidId.size() != b.bidId.size()) {
+            return a.bidId.size() < b.bidId.size() ? -1 : 1;
+        }
+        return a.bidId.compare(b.bidId);
+    }
+};
+
+struct TitleField {
+    static int compare(const Bid& a, const Bid& b) {
+        return a.title.compare(b.title);
+    }
+};
+
+struct FundField {
+    static int compare(const Bid& a, const Bid& b) {
+        return a.fund.compare(b.fund);
+    }
+};
+
+/**
+ * Paid dates compared by day rather than as MM/DD/YYYY text, a date that
+ * can't be read goes before every date
+ */
+struct DatePaidField {
+    static uint32_t day(const string& text) {
+        uint32_t packed = 0;
+        packDate(text, packed);
+        return packed;
+    }
+    static int compare(const Bid& a, const Bid& b) {
+        return threeWay(day(a.datePaid), day(b.datePaid));
+    }
+};
+
+struct ReceiptNumberField {
+    static int compare(const Bid& a, const Bid& b) {
+        return a.receiptNumber.compare(b.receiptNumber);
+    }
+};
+
+struct NetSalesField {
+    static int compare(const Bid& a, const Bid& b) {
+        return threeWay(a.netSales, b.netSales);
+    }
+};
+
+struct AmountField {
+    static int compare(const Bid& a, const Bid& b) {
+        return threeWay(a.amount, b.amount);
+    }
+};
+
+//============================================================================
+// Sort Spec definition
+//============================================================================
+
+/**
+ * A field sorted smallest first
+ */
+template <typename Field>
+struct Ascending {
+    static int compare(const Bid& a, const Bid& b) {
+        return Field::compare(a, b);
+    }
+};
+
+/**
+ * A field sorted largest first
+ */
+template <typename Field>
+struct Descending {
+    static int compare(const Bid& a, const Bid& b) {
+        return Field::compare(b, a);
+    }
+};
+
+/**
+ * Comparison of bids on a list of fields, each ascending or descending,
+ * where each field only decides when the fields before it are the same:
+ *
+ *     SortSpec<Ascending<FundField>, Descending<AmountField>>
+ *
+ * orders bids by fund and then by largest winning bid within a fund. The
+ * fields are fixed when the spec is compiled, so every field's comparison
+ * is inlined into one function with nothing looked up while sorting, the
+ * same code as a comparison written out by hand. Each text field is read
+ * once per comparison with a three way compare.
+ */
+template <typename... Keys>
+struct SortSpec {
+    bool operator()(const Bid& a, const Bid& b) const {
+        int result = 0;
+        // stops at the first field that tells the bids apart
+        (void) (((result = Keys::compare(a, b)) != 0) || ...);
+        return result < 0;
+    }
+};
@@ -6,8 +6,10 @@
 #include <iostream>
 #include <time.h>
 #include <climits>
+#include <cstdint>
 #include <vector>
 #include <string>
+#include <iterator>
 
 #include "CSVparser.hpp"
 
@@ -18,10 +20,56 @@ using namespace std;
 //============================================================================
 
 class VectorSort {
+private:
+    // the first bytes of a title packed so comparing the numbers compares
+    // the bytes, along with where the bid is in the vector
+    struct TitleKey {
+        uint64_t prefix;
+        unsigned int index;
+    };
+    static uint64_t titlePrefix(const string& title);
+    static void applyOrder(vector<Bid>& bids, vector<unsigned int>& order);
+
+    // a title seen one byte at a time by the multikey quicksort
+    struct TitleRef {
+        const unsigned char* text;
+        unsigned int length;
+        unsigned int index;
+    };
+    // runs shorter than this are finished by insertion sort
+    static const size_t MULTIKEY_CUTOFF = 16;
+    static int byteAt(const TitleRef& title, size_t depth);
+    static bool titleLess(const TitleRef& a, const TitleRef& b, size_t depth, size_t& compared);
+    static void multikeySort(TitleRef* titles, size_t size, size_t depth, size_t& compared);
+
+    // runs shorter than this are finished by insertion sort, and runs
+    // longer than the second take the median of three medians as pivot
+    static const ptrdiff_t INSERTION_CUTOFF = 24;
+    static const ptrdiff_t NINTHER_CUTOFF = 128;
+    template <typename Less> static void sort3(Bid* a, Bid* b, Bid* c, Less less);
+    template <typename Less> static void insertionSort(Bid* begin, Bid* end, Less less);
+    template <typename Less> static bool partialInsertionSort(Bid* begin, Bid* end, Less less);
+    template <typename Less> static pair<Bid*, bool> partitionRight(Bid* begin, Bid* end, Less less);
+    template <typename Less> static Bid* partitionLeft(Bid* begin, Bid* end, Less less);
+    template <typename Less> static void introSort(Bid* begin, Bid* end, Less less, int badAllowed, bool leftmost);
+
+    // ranges shorter than this are sorted or merged on one thread
+    static const size_t PARALLEL_CUTOFF = 4096;
+    static void mergeSort(WorkStealingPool& pool, Bid* bids, Bid* scratch, size_t size, bool intoScratch);
+    static void merge(WorkStealingPool& pool, Bid* first, size_t firstSize, Bid* second, size_t secondSize,
+                      Bid* out);
+
 public:
     static int partition(vector<Bid>&, int, int);
+    template <typename Less> static int partition(vector<Bid>&, int, int, Less);
     static void quickSort(vector<Bid>&, int, int);
+    template <typename Less> static void quickSort(vector<Bid>&, int, int, Less);
     static void selectionSort(vector<Bid>&);
+    static void parallelSort(vector<Bid>&, unsigned int);
+    static void parallelSort(vector<Bid>&, WorkStealingPool&);
+    static vector<unsigned int> sortedOrder(const vector<Bid>&);
+    static void indirectSort(vector<Bid>&);
+    static void multikeySort(vector<Bid>&, size_t* comparisons = nullptr);
     static vector<Bid> loadBids(string);
 };
 
@@ -36,25 +84,26 @@ vector<Bid> VectorSort::loadBids(string csvPath) {
     // Define a vector data structure to hold a collection of bids.
     vector<Bid> bids;
 
-    // initialize the CSV Parser using the given path
-    csv::Parser file = csv::Parser(csvPath);
+    // initialize the CSV Reader, rows are parsed one at a time as they are loaded
+    // and only the bid columns are kept
+    csv::Reader file = csv::Reader(csvPath, csv::eMMAP, ',', BID_COLUMNS);
 
     try {
         // loop to read rows of a CSV file
-        for (int i = 0; i < file.rowCount(); i++) {
+        while (file.next()) {
 
             // Create a data structure and add to the collection of bids
             Bid bid;
-            bid.bidId = file[i][1];
-            bid.title = file[i][0];
-            bid.fund = file[i][19];
-            bid.datePaid = file[i][10];
-            bid.receiptNumber = file[i][15];
-            bid.netSales = strToDouble(file[i][18],'$');
-            bid.amount = strToDouble(file[i][4], '$');
+            bid.bidId = string(file[BID_ID]);
+            bid.title = string(file[TITLE]);
+            bid.fund = string(file[FUND]);
+            bid.datePaid = string(file[DATE_PAID]);
+            bid.receiptNumber = string(file[RECEIPT_NUMBER]);
+            bid.netSales = currencyToDouble(file[NET_SALES]);
+            bid.amount = currencyToDouble(file[AMOUNT]);
 
             // push this bid to the end
-            bids.push_back(bid);
+            bids.push_back(move(bid));
         }
     } catch (csv::Error &e) {
         std::cerr << e.what() << std::endl;
@@ -63,17 +112,30 @@ vector<Bid> VectorSort::loadBids(string csvPath) {
 }
 
 /**
- * Partition the vector of bids into two parts, low and high
+ * Partition the vector of bids into two parts, low and high, on title
  *
  * @param bids Address of the vector<Bid> instance to be partitioned
  * @param begin Beginning index to partition
  * @param end Ending index to partition
  */
 int VectorSort::partition(vector<Bid>& bids, int begin, int end) {
+    return partition(bids, begin, end, [](const Bid& a, const Bid& b) { return a.title < b.title; });
+}
+
+/**
+ * Partition the vector of bids into two parts, low and high
+ *
+ * @param bids Address of the vector<Bid> instance to be partitioned
+ * @param begin Beginning index to partition
+ * @param end Ending index to partition
+ * @param less the order to partition in
+ */
+template <typename Less>
+int VectorSort::partition(vector<Bid>& bids, int begin, int end, Less less) {
     // Initialize variables
     int midPoint, low, high;
     bool done = false;
-    Bid pivot, temp;
+    Bid pivot;
 
     // pick middle variable as pivot
     midPoint = begin + (end - begin) / 2;
@@ -83,10 +145,10 @@ int VectorSort::partition(vector<Bid>& bids, int begin, int end) {
     high = end;
 
     while (!done) {
-        while (bids[low].title < pivot.title) {
+        while (less(bids[low], pivot)) {
             ++low;
         }
-        while (pivot.title < bids[high].title) {
+        while (less(pivot, bids[high])) {
             --high;
         }
         if (low >= high) {
@@ -94,9 +156,7 @@ int VectorSort::partition(vector<Bid>& bids, int begin, int end) {
         }
         else {
             // Swap values and update variables
-            temp = bids[low];
-            bids[low] = bids[high];
-            bids[high] = temp;
+            swap(bids[low], bids[high]);
 
             ++low;
             --high;
@@ -108,30 +168,286 @@ int VectorSort::partition(vector<Bid>& bids, int begin, int end) {
 /**
  * Perform a quick sort on bid title
  * Average performance: O(n log(n))
- * Worst case performance O(n^2))
+ * Worst case performance O(n log(n))
  *
  * @param bids address of the vector<Bid> instance to be sorted
  * @param begin the beginning index to sort on
  * @param end the ending index to sort on
  */
 void VectorSort::quickSort(vector<Bid>& bids, int begin, int end) {
-    // Initialize variables
-    int j = 0;
+    quickSort(bids, begin, end, [](const Bid& a, const Bid& b) { return a.title < b.title; });
+}
 
+/**
+ * Perform a quick sort in the order given by a comparison. The pivot is
+ * the median of three bids, or of three medians of three on long runs,
+ * runs of equal bids are split off in one pass, short runs finish with
+ * insertion sort, and once too many partitions come out lopsided the
+ * run is heap sorted, so no input takes more than O(n log(n)).
+ * Average performance: O(n log(n))
+ * Worst case performance O(n log(n))
+ *
+ * @param bids address of the vector<Bid> instance to be sorted
+ * @param begin the beginning index to sort on
+ * @param end the ending index to sort on
+ * @param less the order to sort in
+ */
+template <typename Less>
+void VectorSort::quickSort(vector<Bid>& bids, int begin, int end, Less less) {
     // check to see if list is already sorted
     if (begin >= end) {
         return;
     }
 
-    // Partition the array to being sorting
-    j = VectorSort::partition(bids, begin, end);
+    // allow about log2(n) lopsided partitions before heap sorting
+    int badAllowed = 0;
+    for (int size = end - begin + 1; size > 1; size >>= 1) {
+        badAllowed++;
+    }
+    introSort(bids.data() + begin, bids.data() + end + 1, less, badAllowed, true);
+}
 
-    // Sort low and high partitions
-    quickSort(bids, begin, j);
-    quickSort(bids, j + 1, end);
+/**
+ * Put three bids in order
+ */
+template <typename Less>
+void VectorSort::sort3(Bid* a, Bid* b, Bid* c, Less less) {
+    if (less(*b, *a)) {
+        swap(*a, *b);
+    }
+    if (less(*c, *b)) {
+        swap(*b, *c);
+    }
+    if (less(*b, *a)) {
+        swap(*a, *b);
+    }
+}
 
-    return;
+/**
+ * Perform an insertion sort on a short run of bids
+ *
+ * @param begin the first bid of the run
+ * @param end just past the last bid of the run
+ * @param less the order to sort in
+ */
+template <typename Less>
+void VectorSort::insertionSort(Bid* begin, Bid* end, Less less) {
+    if (begin == end) {
+        return;
+    }
+    for (Bid* i = begin + 1; i != end; ++i) {
+        if (less(*i, *(i - 1))) {
+            Bid held = move(*i);
+            Bid* j = i;
+            do {
+                *j = move(*(j - 1));
+                --j;
+            } while (j != begin && less(held, *(j - 1)));
+            *j = move(held);
+        }
+    }
+}
 
+/**
+ * Try to finish a run that is nearly in order with insertion sort,
+ * giving up once more than a few bids have had to move
+ *
+ * @param begin the first bid of the run
+ * @param end just past the last bid of the run
+ * @param less the order to sort in
+ * @return true if the run is now sorted
+ */
+template <typename Less>
+bool VectorSort::partialInsertionSort(Bid* begin, Bid* end, Less less) {
+    if (begin == end) {
+        return true;
+    }
+    size_t moved = 0;
+    for (Bid* i = begin + 1; i != end; ++i) {
+        if (less(*i, *(i - 1))) {
+            Bid held = move(*i);
+            Bid* j = i;
+            do {
+                *j = move(*(j - 1));
+                --j;
+            } while (j != begin && less(held, *(j - 1)));
+            *j = move(held);
+            moved += i - j;
+            if (moved > 8) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Partition a run around the pivot at its start, bids less than the
+ * pivot go left of it and the rest go right of it. A bid at least as
+ * large as the pivot must follow it, which choosing the pivot by median
+ * makes sure of.
+ *
+ * @param begin the pivot, followed by the rest of the run
+ * @param end just past the last bid of the run
+ * @param less the order to sort in
+ * @return where the pivot ended up, and whether the run was already
+ *         partitioned without moving any bids
+ */
+template <typename Less>
+pair<Bid*, bool> VectorSort::partitionRight(Bid* begin, Bid* end, Less less) {
+    const Bid& pivot = *begin;
+    Bid* first = begin;
+    Bid* last = end;
+
+    // find the first pair of bids on the wrong sides, only the search
+    // from the right can run off the run, when nothing is less than the pivot
+    while (less(*++first, pivot)) {
+    }
+    if (first - 1 == begin) {
+        while (first < last && !less(*--last, pivot)) {
+        }
+    } else {
+        while (!less(*--last, pivot)) {
+        }
+    }
+    bool alreadyPartitioned = first >= last;
+
+    // each swap leaves a bid on either side that stops the next searches
+    while (first < last) {
+        swap(*first, *last);
+        while (less(*++first, pivot)) {
+        }
+        while (!less(*--last, pivot)) {
+        }
+    }
+
+    Bid* pivotPosition = first - 1;
+    swap(*begin, *pivotPosition);
+    return make_pair(pivotPosition, alreadyPartitioned);
+}
+
+/**
+ * Partition a run around the pivot at its start, bids equal to the pivot
+ * go left of it with anything smaller. Used when the pivot equals the bid
+ * before the run, so nothing in the run is smaller and every bid that
+ * goes left is equal to the pivot and already in place.
+ *
+ * @param begin the pivot, followed by the rest of the run
+ * @param end just past the last bid of the run
+ * @param less the order to sort in
+ * @return where the pivot ended up
+ */
+template <typename Less>
+Bid* VectorSort::partitionLeft(Bid* begin, Bid* end, Less less) {
+    const Bid& pivot = *begin;
+    Bid* first = begin;
+    Bid* last = end;
+
+    // the pivot itself stops the search from the right
+    while (less(pivot, *--last)) {
+    }
+    if (last + 1 == end) {
+        while (first < last && !less(pivot, *++first)) {
+        }
+    } else {
+        while (!less(pivot, *++first)) {
+        }
+    }
+
+    while (first < last) {
+        swap(*first, *last);
+        while (less(pivot, *--last)) {
+        }
+        while (!less(pivot, *++first)) {
+        }
+    }
+
+    swap(*begin, *last);
+    return last;
+}
+
+/**
+ * (Recursive) Sort a run of bids, recursing on the left part of each
+ * partition and looping on the right part
+ *
+ * @param begin the first bid of the run
+ * @param end just past the last bid of the run
+ * @param less the order to sort in
+ * @param badAllowed lopsided partitions left before heap sorting
+ * @param leftmost false if a bid no larger than any in the run comes
+ *                 right before it
+ */
+template <typename Less>
+void VectorSort::introSort(Bid* begin, Bid* end, Less less, int badAllowed, bool leftmost) {
+    while (true) {
+        ptrdiff_t size = end - begin;
+        if (size < INSERTION_CUTOFF) {
+            insertionSort(begin, end, less);
+            return;
+        }
+
+        // move the median to the start as the pivot
+        Bid* middle = begin + size / 2;
+        if (size > NINTHER_CUTOFF) {
+            sort3(begin, middle, end - 1, less);
+            sort3(begin + 1, middle - 1, end - 2, less);
+            sort3(begin + 2, middle + 1, end - 3, less);
+            sort3(middle - 1, middle, middle + 1, less);
+            swap(*begin, *middle);
+        } else {
+            sort3(middle, begin, end - 1, less);
+        }
+
+        // a pivot equal to the bid before the run means the run starts
+        // with bids equal to it, put them all in place in one pass
+        if (!leftmost && !less(*(begin - 1), *begin)) {
+            begin = partitionLeft(begin, end, less) + 1;
+            continue;
+        }
+
+        pair<Bid*, bool> partitioned = partitionRight(begin, end, less);
+        Bid* pivot = partitioned.first;
+        ptrdiff_t leftSize = pivot - begin;
+        ptrdiff_t rightSize = end - (pivot + 1);
+
+        if (leftSize < size / 8 || rightSize < size / 8) {
+            // lopsided, give up on quick sort if it keeps happening and
+            // otherwise swap a few bids around to break up the pattern
+            if (--badAllowed == 0) {
+                make_heap(begin, end, less);
+                sort_heap(begin, end, less);
+                return;
+            }
+            if (leftSize >= INSERTION_CUTOFF) {
+                swap(*begin, *(begin + leftSize / 4));
+                swap(*(pivot - 1), *(pivot - leftSize / 4));
+                if (leftSize > NINTHER_CUTOFF) {
+                    swap(*(begin + 1), *(begin + (leftSize / 4 + 1)));
+                    swap(*(begin + 2), *(begin + (leftSize / 4 + 2)));
+                    swap(*(pivot - 2), *(pivot - (leftSize / 4 + 1)));
+                    swap(*(pivot - 3), *(pivot - (leftSize / 4 + 2)));
+                }
+            }
+            if (rightSize >= INSERTION_CUTOFF) {
+                swap(*(pivot + 1), *(pivot + (1 + rightSize / 4)));
+                swap(*(end - 1), *(end - rightSize / 4));
+                if (rightSize > NINTHER_CUTOFF) {
+                    swap(*(pivot + 2), *(pivot + (2 + rightSize / 4)));
+                    swap(*(pivot + 3), *(pivot + (3 + rightSize / 4)));
+                    swap(*(end - 2), *(end - (1 + rightSize / 4)));
+                    swap(*(end - 3), *(end - (2 + rightSize / 4)));
+                }
+            }
+        } else if (partitioned.second && partialInsertionSort(begin, pivot, less)
+                   && partialInsertionSort(pivot + 1, end, less)) {
+            // nothing moved and both sides were nearly in order
+            return;
+        }
+
+        introSort(begin, pivot, less, badAllowed, leftmost);
+        begin = pivot + 1;
+        leftmost = false;
+    }
 }
 
 /**
@@ -144,7 +460,6 @@ void VectorSort::quickSort(vector<Bid>& bids, int begin, int end) {
  */
 void VectorSort::selectionSort(vector<Bid>& bids) {
     // Initialize variables
-    Bid temp;
     int smallest;
 
     // Iterate through the each of the items in the vector
@@ -157,8 +472,311 @@ void VectorSort::selectionSort(vector<Bid>& bids) {
                 smallest = j;
         }
         // swap variables to sort
-        temp = bids[i];
-        bids[i] = bids[smallest];
-        bids[smallest] = temp;
+        swap(bids[i], bids[smallest]);
+    }
+}
+
+/**
+ * Perform a parallel merge sort on bid title, bids with the same title
+ * keep their order
+ * Average performance: O(n log(n)) work, O(log(n)^3) span
+ * Worst case performance O(n log(n))
+ *
+ * @param bids address of the vector<Bid> instance to be sorted
+ * @param threads number of threads to sort on
+ */
+void VectorSort::parallelSort(vector<Bid>& bids, unsigned int threads) {
+    WorkStealingPool pool(threads);
+    parallelSort(bids, pool);
+}
+
+/**
+ * Perform a parallel merge sort on bid title using the threads of a pool
+ *
+ * @param bids address of the vector<Bid> instance to be sorted
+ * @param pool the pool to sort on
+ */
+void VectorSort::parallelSort(vector<Bid>& bids, WorkStealingPool& pool) {
+    if (pool.Threads() <= 1 || bids.size() <= PARALLEL_CUTOFF) {
+        stable_sort(bids.begin(), bids.end(), [](const Bid& a, const Bid& b) { return a.title < b.title; });
+        return;
+    }
+    vector<Bid> scratch(bids.size());
+    mergeSort(pool, bids.data(), scratch.data(), bids.size(), false);
+}
+
+/**
+ * (Recursive) Sort the two halves of a range at the same time and merge
+ * them, the halves are sorted into the other buffer so each level of the
+ * recursion moves every bid just once
+ *
+ * @param pool the pool to sort on
+ * @param bids the range to sort
+ * @param scratch a range of the same size to sort through
+ * @param size number of bids in the range
+ * @param intoScratch true to leave the sorted bids in scratch
+ */
+void VectorSort::mergeSort(WorkStealingPool& pool, Bid* bids, Bid* scratch, size_t size, bool intoScratch) {
+    if (size <= PARALLEL_CUTOFF) {
+        stable_sort(bids, bids + size, [](const Bid& a, const Bid& b) { return a.title < b.title; });
+        if (intoScratch) {
+            move(bids, bids + size, scratch);
+        }
+        return;
+    }
+
+    size_t half = size / 2;
+    TaskGroup group;
+    pool.Run(group, [&] { mergeSort(pool, bids, scratch, half, !intoScratch); });
+    mergeSort(pool, bids + half, scratch + half, size - half, !intoScratch);
+    pool.Wait(group);
+
+    if (intoScratch) {
+        merge(pool, bids, half, bids + half, size - half, scratch);
+    } else {
+        merge(pool, scratch, half, scratch + half, size - half, bids);
+    }
+}
+
+/**
+ * (Recursive) Merge two sorted ranges by splitting the larger one at its
+ * middle bid, finding where that bid falls in the other one and merging
+ * the two sides at the same time. Bids from the first range go before
+ * bids from the second range with the same title.
+ *
+ * @param pool the pool to merge on
+ * @param first the first sorted range, moved from
+ * @param firstSize number of bids in the first range
+ * @param second the second sorted range, moved from
+ * @param secondSize number of bids in the second range
+ * @param out where the merged bids are moved to
+ */
+void VectorSort::merge(WorkStealingPool& pool, Bid* first, size_t firstSize, Bid* second, size_t secondSize,
+                       Bid* out) {
+    auto byTitle = [](const Bid& a, const Bid& b) { return a.title < b.title; };
+    if (firstSize + secondSize <= PARALLEL_CUTOFF) {
+        std::merge(make_move_iterator(first), make_move_iterator(first + firstSize),
+                   make_move_iterator(second), make_move_iterator(second + secondSize), out, byTitle);
+        return;
+    }
+
+    size_t firstSplit, secondSplit;
+    if (firstSize >= secondSize) {
+        firstSplit = firstSize / 2;
+        secondSplit = lower_bound(second, second + secondSize, first[firstSplit], byTitle) - second;
+    } else {
+        secondSplit = secondSize / 2;
+        firstSplit = upper_bound(first, first + firstSize, second[secondSplit], byTitle) - first;
+    }
+
+    TaskGroup group;
+    pool.Run(group, [&] { merge(pool, first, firstSplit, second, secondSplit, out); });
+    merge(pool, first + firstSplit, firstSize - firstSplit, second + secondSplit, secondSize - secondSplit,
+          out + firstSplit + secondSplit);
+    pool.Wait(group);
+}
+
+/**
+ * Pack the first 8 bytes of a title into a number, highest byte first and
+ * padded with zeros, so numbers compare the same way as the titles'
+ * first 8 bytes do
+ *
+ * @param title the title to pack
+ */
+uint64_t VectorSort::titlePrefix(const string& title) {
+    uint64_t prefix = 0;
+    size_t length = min<size_t>(title.size(), 8);
+    for (size_t i = 0; i < length; ++i) {
+        prefix |= uint64_t((unsigned char) title[i]) << (56 - 8 * i);
+    }
+    return prefix;
+}
+
+/**
+ * Find the order the bids would be in if sorted on title, without moving
+ * them. Small keys holding the start of each title are sorted instead of
+ * the bids, and the titles are only read when two starts are the same.
+ * Bids with the same title keep their order.
+ * Average performance: O(n log(n))
+ * Worst case performance O(n log(n))
+ *
+ * @param bids the bids to sort
+ * @return the positions of the bids in sorted order, a sorted view
+ */
+vector<unsigned int> VectorSort::sortedOrder(const vector<Bid>& bids) {
+    vector<TitleKey> keys(bids.size());
+    for (unsigned int i = 0; i < bids.size(); ++i) {
+        keys[i] = TitleKey{titlePrefix(bids[i].title), i};
+    }
+    sort(keys.begin(), keys.end(), [&](const TitleKey& a, const TitleKey& b) {
+        if (a.prefix != b.prefix) {
+            return a.prefix < b.prefix;
+        }
+        int compared = bids[a.index].title.compare(bids[b.index].title);
+        return compared != 0 ? compared < 0 : a.index < b.index;
+    });
+
+    vector<unsigned int> order(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        order[i] = keys[i].index;
+    }
+    return order;
+}
+
+/**
+ * Perform an indirect sort on bid title, sorting small keys and then
+ * moving each bid once straight to its place
+ * Average performance: O(n log(n))
+ * Worst case performance O(n log(n))
+ *
+ * @param bids address of the vector<Bid> instance to be sorted
+ */
+void VectorSort::indirectSort(vector<Bid>& bids) {
+    vector<unsigned int> order = sortedOrder(bids);
+    applyOrder(bids, order);
+}
+
+/**
+ * Move the bids into a new order, each bid is moved once
+ *
+ * @param bids the bids to reorder
+ * @param order the position of the bid that goes in each place, used up
+ */
+void VectorSort::applyOrder(vector<Bid>& bids, vector<unsigned int>& order) {
+    // follow each cycle of the permutation, filling every place from the
+    // bid that belongs there, and mark the places done as it goes
+    for (unsigned int start = 0; start < order.size(); ++start) {
+        if (order[start] == start || order[start] == UINT_MAX) {
+            continue;
+        }
+        Bid held = move(bids[start]);
+        unsigned int place = start;
+        while (order[place] != start) {
+            unsigned int from = order[place];
+            bids[place] = move(bids[from]);
+            order[place] = UINT_MAX;
+            place = from;
+        }
+        bids[place] = move(held);
+        order[place] = UINT_MAX;
+    }
+}
+
+/**
+ * Get a byte of a title shifted up by one, with 0 past the end, so a
+ * title that ends sorts before every title it is the start of
+ */
+int VectorSort::byteAt(const TitleRef& title, size_t depth) {
+    return depth < title.length ? title.text[depth] + 1 : 0;
+}
+
+/**
+ * Compare two titles that are known to share their first bytes, bids with
+ * the same title are kept in order
+ *
+ * @param depth number of bytes already known to be the same
+ * @param compared count of bytes compared, added to
+ */
+bool VectorSort::titleLess(const TitleRef& a, const TitleRef& b, size_t depth, size_t& compared) {
+    while (true) {
+        int left = byteAt(a, depth);
+        int right = byteAt(b, depth);
+        compared++;
+        if (left != right) {
+            return left < right;
+        }
+        if (left == 0) {
+            return a.index < b.index;
+        }
+        depth++;
+    }
+}
+
+/**
+ * (Recursive) Multikey quicksort of titles that share their first bytes.
+ * The titles are split three ways on one byte, the ones with the same
+ * byte as the pivot go on to the next byte and never compare the bytes
+ * before it again.
+ *
+ * @param titles the titles to sort
+ * @param size number of titles
+ * @param depth number of bytes all the titles share
+ * @param compared count of bytes compared, added to
+ */
+void VectorSort::multikeySort(TitleRef* titles, size_t size, size_t depth, size_t& compared) {
+    while (size > MULTIKEY_CUTOFF) {
+        // median of three bytes for the pivot
+        int a = byteAt(titles[0], depth);
+        int b = byteAt(titles[size / 2], depth);
+        int c = byteAt(titles[size - 1], depth);
+        compared += 3;
+        int pivot = max(min(a, b), min(max(a, b), c));
+
+        // below the pivot to the left, above it to the right
+        size_t lower = 0, i = 0, upper = size;
+        while (i < upper) {
+            int byte = byteAt(titles[i], depth);
+            compared++;
+            if (byte < pivot) {
+                swap(titles[lower++], titles[i++]);
+            } else if (byte > pivot) {
+                swap(titles[i], titles[--upper]);
+            } else {
+                i++;
+            }
+        }
+
+        multikeySort(titles, lower, depth, compared);
+        multikeySort(titles + upper, size - upper, depth, compared);
+        if (pivot == 0) {
+            // every title in the middle ended, they are all the same
+            sort(titles + lower, titles + upper,
+                 [](const TitleRef& x, const TitleRef& y) { return x.index < y.index; });
+            return;
+        }
+        titles += lower;
+        size = upper - lower;
+        depth++;
+    }
+
+    for (size_t i = 1; i < size; ++i) {
+        TitleRef title = titles[i];
+        size_t j = i;
+        while (j > 0 && titleLess(title, titles[j - 1], depth, compared)) {
+            titles[j] = titles[j - 1];
+            --j;
+        }
+        titles[j] = title;
+    }
+}
+
+/**
+ * Perform a multikey quicksort on bid title. Bytes are compared one at a
+ * time, and titles with the same first bytes never compare those bytes
+ * again, where comparing whole titles rescans shared starts like "Dell
+ * Optiplex" every time. The bids are put in the same order as sorting on
+ * title with operator<, and bids with the same title keep their order.
+ * Average performance: O(n log(n) + total length of the distinct starts)
+ * Worst case performance O(n^2))
+ *
+ * @param bids address of the vector<Bid> instance to be sorted
+ * @param comparisons if given, set to the number of bytes compared
+ */
+void VectorSort::multikeySort(vector<Bid>& bids, size_t* comparisons) {
+    vector<TitleRef> titles(bids.size());
+    for (unsigned int i = 0; i < bids.size(); ++i) {
+        const string& title = bids[i].title;
+        titles[i] = TitleRef{(const unsigned char*) title.data(), (unsigned int) title.size(), i};
+    }
+    size_t compared = 0;
+    multikeySort(titles.data(), titles.size(), 0, compared);
+    if (comparisons != nullptr) {
+        *comparisons = compared;
+    }
+
+    vector<unsigned int> order(titles.size());
+    for (size_t i = 0; i < titles.size(); ++i) {
+        order[i] = titles[i].index;
     }
+    applyOrder(bids, order);
 }
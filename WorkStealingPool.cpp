@@ -0,0 +1,226 @@
+//
+// Thread pool where idle threads steal work from busy ones
+//
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//============================================================================
+// Work Stealing Pool class definition
+//============================================================================
+
+/**
+ * Tasks run together on a pool that can be waited for as a group
+ */
+struct TaskGroup {
+    atomic<size_t> pending;
+    mutex errorLock;
+    exception_ptr error;
+    TaskGroup() : pending(0) {
+    }
+};
+
+/**
+ * Class that runs fork-join tasks on a fixed set of threads. Every thread
+ * has its own queue, it adds and takes tasks at the back so the work it
+ * just split off stays in its cache, and threads with nothing to do take
+ * tasks from the front of another thread's queue, where the largest
+ * pieces of work are.
+ *
+ * The thread that calls Wait works through tasks until its group is done
+ * instead of blocking, so a task may split itself and wait for the parts
+ * without tying up a thread. One thread from outside the pool uses it at
+ * a time, as queue 0, and the pool starts one thread fewer than asked.
+ */
+class WorkStealingPool {
+
+private:
+    struct Task {
+        function<void()> work;
+        TaskGroup* group;
+    };
+
+    struct alignas(64) Queue {
+        mutex lock;
+        deque<Task> tasks;
+    };
+
+    unique_ptr<Queue[]> queues;
+    unsigned int threadCount;
+    vector<thread> workers;
+    atomic<size_t> queued;
+    mutex sleepLock;
+    condition_variable wake;
+    bool stopping;
+    // queue of the pool thread running this code, 0 outside the pool
+    static thread_local const WorkStealingPool* current;
+    static thread_local unsigned int currentQueue;
+    unsigned int queueOf() const;
+    bool runOne(unsigned int index);
+    void work(unsigned int index);
+
+public:
+    WorkStealingPool(unsigned int threads);
+    virtual ~WorkStealingPool();
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+    void Run(TaskGroup& group, function<void()> work);
+    void Wait(TaskGroup& group);
+    unsigned int Threads() const;
+};
+
+thread_local const WorkStealingPool* WorkStealingPool::current = nullptr;
+thread_local unsigned int WorkStealingPool::currentQueue = 0;
+
+/**
+ * Constructor
+ * @param threads number of threads to run tasks on, counting the caller
+ */
+WorkStealingPool::WorkStealingPool(unsigned int threads) : queued(0) {
+    threadCount = threads == 0 ? 1 : threads;
+    queues.reset(new Queue[threadCount]);
+    stopping = false;
+    for (unsigned int i = 1; i < threadCount; ++i) {
+        workers.push_back(thread(&WorkStealingPool::work, this, i));
+    }
+}
+
+/**
+ * Destructor, every group must have been waited for
+ */
+WorkStealingPool::~WorkStealingPool() {
+    {
+        lock_guard<mutex> guard(sleepLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (thread& worker : workers) {
+        worker.join();
+    }
+}
+
+/**
+ * Get the queue of the calling thread
+ */
+unsigned int WorkStealingPool::queueOf() const {
+    return current == this ? currentQueue : 0;
+}
+
+/**
+ * Run one task, from a thread's own queue if it has any and otherwise
+ * taken from another thread
+ * @param index the queue of the calling thread
+ * @return false if every queue was empty
+ */
+bool WorkStealingPool::runOne(unsigned int index) {
+    Task task;
+    bool found = false;
+    {
+        Queue& own = queues[index];
+        lock_guard<mutex> guard(own.lock);
+        if (!own.tasks.empty()) {
+            task = move(own.tasks.back());
+            own.tasks.pop_back();
+            found = true;
+        }
+    }
+    for (unsigned int i = 1; !found && i < threadCount; ++i) {
+        Queue& victim = queues[(index + i) % threadCount];
+        lock_guard<mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = move(victim.tasks.front());
+            victim.tasks.pop_front();
+            found = true;
+        }
+    }
+    if (!found) {
+        return false;
+    }
+    queued.fetch_sub(1, memory_order_relaxed);
+
+    try {
+        task.work();
+    } catch (...) {
+        lock_guard<mutex> guard(task.group->errorLock);
+        if (!task.group->error) {
+            task.group->error = current_exception();
+        }
+    }
+    task.group->pending.fetch_sub(1, memory_order_release);
+    return true;
+}
+
+/**
+ * Loop run by each pool thread, sleeping while there is nothing queued
+ * @param index the thread's queue
+ */
+void WorkStealingPool::work(unsigned int index) {
+    current = this;
+    currentQueue = index;
+    while (true) {
+        if (runOne(index)) {
+            continue;
+        }
+        unique_lock<mutex> lock(sleepLock);
+        wake.wait(lock, [this] { return stopping || queued.load(memory_order_relaxed) > 0; });
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+/**
+ * Queue a task to run on whichever thread gets to it first
+ * @param group the group the task is waited for with
+ * @param work the task
+ */
+void WorkStealingPool::Run(TaskGroup& group, function<void()> work) {
+    group.pending.fetch_add(1, memory_order_relaxed);
+    {
+        // counted before it is queued so the count never drops below zero,
+        // and under the lock so a thread about to sleep sees it
+        lock_guard<mutex> guard(sleepLock);
+        queued.fetch_add(1, memory_order_relaxed);
+    }
+    {
+        Queue& own = queues[queueOf()];
+        lock_guard<mutex> guard(own.lock);
+        own.tasks.push_back(Task{move(work), &group});
+    }
+    wake.notify_one();
+}
+
+/**
+ * Run tasks until every task of a group has finished
+ * @param group the group to wait for
+ * @throws the first exception thrown by a task of the group
+ */
+void WorkStealingPool::Wait(TaskGroup& group) {
+    unsigned int index = queueOf();
+    while (group.pending.load(memory_order_acquire) > 0) {
+        if (!runOne(index)) {
+            this_thread::yield();
+        }
+    }
+    if (group.error) {
+        exception_ptr error = group.error;
+        group.error = nullptr;
+        rethrow_exception(error);
+    }
+}
+
+/**
+ * Number of threads the pool runs tasks on, counting the caller
+ */
+unsigned int WorkStealingPool::Threads() const {
+    return threadCount;
+}
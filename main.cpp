@@ -10,15 +10,36 @@
 #include <iostream>
 #include <time.h>
 #include <climits>
+#include <limits>
 #include <vector>
 #include <string>
 #include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <thread>
+#include <random>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <map>
+#include <malloc.h>
+#include <unistd.h>
 
 #include "CSVparser.hpp"
+#include "NodePool.cpp"
 #include "LinkedList.cpp"
 #include "HashTable.cpp"
+#include "EpochReclaimer.cpp"
+#include "ConcurrentHashTable.cpp"
+#include "WorkStealingPool.cpp"
 #include "VectorSort.cpp"
 #include "BinarySearchTree.cpp"
+#include "BPlusTree.cpp"
+#include "OrderStatisticTree.cpp"
+#include "ConcurrentSkipList.cpp"
+#include "BidSnapshot.cpp"
+#include "CompactBid.cpp"
+#include "SortSpec.cpp"
 
 using namespace std;
 
@@ -26,6 +47,7 @@ using namespace std;
 //  GLOBAL VARIABLES
 //=================================================
 string csvPath = "eBid_Monthly_Sales.csv";
+string snapshotPath = "eBid_Monthly_Sales.bids";
 clock_t ticks;
 string bidKey;
 
@@ -75,7 +97,7 @@ Bid getBid() {
     cout << "Enter amount: ";
     string strAmount;
     getline(cin, strAmount);
-    bid.amount = strToDouble(strAmount, '$');
+    bid.amount = currencyToDouble(strAmount);
 
     return bid;
 }
@@ -90,6 +112,74 @@ void printTime(clock_t ticks) {
     cout << "time: " << ticks * 1.0 / CLOCKS_PER_SEC << " seconds\n" << endl;
 }
 
+/**
+ * Method used to read a wall clock for the multi-threaded benchmarks,
+ * clock() adds up the CPU time of every thread so it can't show a speedup
+ * @return seconds from an arbitrary starting point
+ */
+double wallSeconds() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Method used to read the resident memory of the application so the
+ * benchmarks can show how much memory a structure is holding on to
+ * @return resident set size in kilobytes, 0 if it can't be read
+ */
+long residentKilobytes() {
+    ifstream statm("/proc/self/statm");
+    long pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/**
+ * Method used to format the printing of memory use for the benchmarks
+ * @param kilobytes resident memory gained by an operation
+ */
+void printMemory(long kilobytes) {
+    cout << "memory: " << kilobytes << " KB resident" << endl;
+}
+
+/**
+ * Parse the CSV with one of the parser modes and show the time it took
+ * along with the memory the parser holds while it is still alive
+ * @param type parser mode to measure
+ * @param name label printed with the results
+ * @param projection columns the parser should keep, all by default
+ */
+void benchmarkParser(csv::DataType type, const string& name,
+                     const csv::Projection& projection = csv::Projection()) {
+    // hand freed heap back to the OS so each run starts from the same point
+    malloc_trim(0);
+    long before = residentKilobytes();
+
+    ticks = clock();
+    csv::Parser file = csv::Parser(csvPath, type, ',', 1, projection);
+    ticks = clock() - ticks;
+
+    cout << name << ": " << file.rowCount() << " rows parsed" << endl;
+    printMemory(residentKilobytes() - before);
+    printTime(ticks); // Method formats the time output
+}
+
+/**
+ * Load the bids for the sort operations, from the binary snapshot when an
+ * up to date one has been created with --convert, otherwise from the CSV.
+ * A snapshot that can't be read falls back to the CSV.
+ * @return a container holding all the bids
+ */
+vector<Bid> loadSortBids() {
+    if (BidSnapshot::IsCurrent(snapshotPath, csvPath)) {
+        try {
+            return BidSnapshot(snapshotPath).ToVector();
+        } catch (exception &e) {
+            cerr << e.what() << ", loading " << csvPath << " instead" << endl;
+        }
+    }
+    return VectorSort::loadBids(csvPath);
+}
+
 /**
  * Method used to show menu options and messages for the sort operations
  * in this application
@@ -103,7 +193,14 @@ void sortMenu() {
     cout << "\nSelection Sort: Average performance: O(n^2))\n"
             "                Worst case performance O(n^2))\n"
             "Quick Sort:     Average performance: O(n log(n))\n"
-            "                Worst case performance O(n^2))\n\n";
+            "                Worst case performance O(n log(n))\n"
+            "Parallel Sort:  Merge sort on as many threads as chosen\n"
+            "                Worst case performance O(n log(n))\n"
+            "Indirect Sort:  Sorts title keys, then moves each bid once\n"
+            "                Worst case performance O(n log(n))\n"
+            "Multikey Sort:  Quick sort on one title byte at a time\n"
+            "                Worst case performance O(n^2))\n"
+            "Option 7 sorts by fund, then paid date, then largest winning bid\n\n";
     cout << "Please select an option from the menu\n"
             "Performance will be displayed in clock ticks and seconds\n";
 
@@ -114,6 +211,10 @@ void sortMenu() {
         cout << "  1. Selection Sort All Bids" << endl;
         cout << "  2. Quick Sort All Bids" << endl;
         cout << "  3. Display All Bids" << endl;
+        cout << "  4. Parallel Sort All Bids" << endl;
+        cout << "  5. Indirect Sort All Bids" << endl;
+        cout << "  6. Multikey Sort All Bids" << endl;
+        cout << "  7. Sort All Bids by Fund, Paid Date and Amount" << endl;
         cout << "  9. Return to Main Menu" << endl;
         cout << "Enter choice: ";
         cin >> choice;
@@ -137,7 +238,7 @@ void sortMenu() {
                 bids.clear();
 
                 // Method call to load the bids to the vector to be sorted
-                bids = VectorSort::loadBids(csvPath);
+                bids = loadSortBids();
 
                 // Print the number of bids loaded to the vector
                 cout << "\n" << bids.size() << " bids ready to be sorted" << endl;
@@ -164,7 +265,7 @@ void sortMenu() {
                 bids.clear();
 
                 // Method call to load the bids to the vector to be sorted
-                bids = VectorSort::loadBids(csvPath);
+                bids = loadSortBids();
 
                 // Print the number of bids loaded to the vector
                 cout << "\n" << bids.size() << " bids ready to be sorted" << endl;
@@ -194,6 +295,74 @@ void sortMenu() {
                 cout << endl;
                 break;
 
+            // Parallel sort all bids
+            case 4: {
+                unsigned int threads = 0;
+                cout << "Enter number of threads: ";
+                cin >> threads;
+                if (cin.fail() || threads == 0) {
+                    cin.clear();
+                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                    cout << "!! Invalid Input Please Try Again !!" << endl;
+                    break;
+                }
+
+                bids = loadSortBids();
+                cout << "\n" << bids.size() << " bids ready to be sorted" << endl;
+                cout << "Sorting Bids on " << threads << " threads\n" << endl;
+
+                // clock() adds up every thread, so the wall clock is shown
+                double start = wallSeconds();
+                VectorSort::parallelSort(bids, threads);
+                cout << bids.size() << " Bids sorted" << endl;
+                cout << "time: " << wallSeconds() - start << " seconds\n" << endl;
+                break;
+            }
+
+            // Indirect sort all bids
+            case 5:
+                bids = loadSortBids();
+                cout << "\n" << bids.size() << " bids ready to be sorted" << endl;
+                cout << "Sorting Bids\n" << endl;
+
+                ticks = clock();
+                VectorSort::indirectSort(bids);
+                cout << bids.size() << " Bids sorted" << endl;
+
+                ticks = clock() - ticks; // current clock ticks minus starting clock ticks
+                printTime(ticks); // Method formats the time output
+                break;
+
+            // Multikey sort all bids
+            case 6:
+                bids = loadSortBids();
+                cout << "\n" << bids.size() << " bids ready to be sorted" << endl;
+                cout << "Sorting Bids\n" << endl;
+
+                ticks = clock();
+                VectorSort::multikeySort(bids);
+                cout << bids.size() << " Bids sorted" << endl;
+
+                ticks = clock() - ticks; // current clock ticks minus starting clock ticks
+                printTime(ticks); // Method formats the time output
+                break;
+
+            // Sort all bids for the fund report
+            case 7:
+                bids = loadSortBids();
+                cout << "\n" << bids.size() << " bids ready to be sorted" << endl;
+                cout << "Sorting Bids\n" << endl;
+
+                ticks = clock();
+                VectorSort::quickSort(bids, 0, bids.size() - 1,
+                                      SortSpec<Ascending<FundField>, Ascending<DatePaidField>,
+                                               Descending<AmountField>>());
+                cout << bids.size() << " Bids sorted" << endl;
+
+                ticks = clock() - ticks; // current clock ticks minus starting clock ticks
+                printTime(ticks); // Method formats the time output
+                break;
+
             // Return to Main Menu found in main()
             case 9:
                 bids.clear();
@@ -206,6 +375,78 @@ void sortMenu() {
         }
     }
 }
+/**
+ * Load the bids from the CSV into the winning bid statistics the first
+ * time they are needed
+ * @param amounts the tree holding the statistics
+ */
+void loadAmounts(OrderStatisticTree* amounts) {
+    if (amounts->Count() == 0) {
+        cout << "\nCreating Winning Bid Statistics" << endl;
+
+        // Start point for clock ticks to count time
+        ticks = clock();
+        int numBids = 0;
+        try {
+            numBids = OrderStatisticTree::loadBids(csvPath, amounts);
+        } catch (csv::Error &e) {
+            // a missing CSV leaves the statistics empty
+            cerr << e.what() << endl;
+        }
+        ticks = clock() - ticks; // current clock ticks minus starting clock ticks
+
+        cout << numBids << " Bids in Winning Bid Statistics" << endl;
+        printTime(ticks); // Method formats the time output
+    }
+}
+
+/**
+ * Show the median and 95th percentile winning bids, the k-th largest
+ * sale and how an amount ranks among all the winning bids
+ * @param amounts the tree holding the statistics
+ */
+void showAmountStatistics(OrderStatisticTree* amounts) {
+    loadAmounts(amounts);
+    if (amounts->Count() == 0) {
+        cout << "No bids loaded, there are no statistics to show" << endl;
+        return;
+    }
+
+    unsigned int k;
+    double amount;
+    cout << "Enter k for the k-th largest sale (1 - " << amounts->Count() << "): ";
+    cin >> k;
+    cout << "Enter a winning bid amount to rank: ";
+    cin >> amount;
+    if (cin.fail()) {
+        cin.clear();
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        cout << "!! Invalid Input Please Try Again !!" << endl;
+        return;
+    }
+
+    // Start point for clock ticks to count time
+    ticks = clock();
+    Bid median = amounts->Percentile(50);
+    Bid high = amounts->Percentile(95);
+    Bid largest = amounts->SelectLargest(min(max(k, 1u), amounts->Count()) - 1);
+    unsigned int rank = amounts->Rank(amount);
+    double below = amounts->PrefixSum(amount);
+    ticks = clock() - ticks; // current clock ticks minus starting clock ticks
+
+    cout << "\n" << amounts->Count() << " winning bids totalling $" << fixed << setprecision(2)
+         << amounts->Total() << endl;
+    cout << left << setw(29) << "Median winning bid:" << "$" << median.amount
+         << " (bid " << median.bidId << ")" << endl;
+    cout << setw(29) << "95th percentile winning bid:" << "$" << high.amount
+         << " (bid " << high.bidId << ")" << endl;
+    cout << setw(29) << "Largest sale #" + to_string(max(k, 1u)) + ":" << "$" << largest.amount
+         << " (bid " << largest.bidId << ")" << endl;
+    cout << rank << " winning bids are below $" << amount << ", totalling $" << below << endl;
+    cout << defaultfloat << setprecision(6);
+    printTime(ticks); // Method formats the time output
+}
+
 /**
  * Method used for the menu of search and insert methods for the different
  * data structures used in the application
@@ -215,6 +456,7 @@ void searchMenu() {
     LinkedList bidList;
     BinarySearchTree* bst = new BinarySearchTree();
     HashTable* bidTable = new HashTable();
+    OrderStatisticTree* amounts = new OrderStatisticTree();
     Bid bid;
 
     // Message explaining different options and data structures in the application
@@ -226,6 +468,8 @@ void searchMenu() {
             "                        Search O(Log N)\n";
     cout << "Hash Table:             Insert O(1)\n"
             "                        Search O(1)\n";
+    cout << "Winning Bid Statistics: Insert O(Log N)\n"
+            "                        Rank, Select and Percentile O(Log N)\n";
     cout << "\nPlease select an option from the menu\n"
             "Performance will be displayed in clock ticks and seconds\n";
 
@@ -241,6 +485,7 @@ void searchMenu() {
         cout << "  6. Hash Table - Search" << endl;
         cout << "  7. Hash Table - Insert" << endl;
         cout << "  8. Display All Bids" << endl;
+        cout << "  10. Winning Bid Statistics" << endl;
         cout << "  9. Exit" << endl;
         cout << "Enter choice: ";
         cin >> choice;
@@ -320,6 +565,10 @@ void searchMenu() {
                 cout << "Bid Appended to Linked List" << endl;
                 printTime(ticks); // Method formats the time output
 
+                // keep the winning bid statistics up to date, outside the timing
+                loadAmounts(amounts);
+                amounts->Insert(bid);
+
                 break;
 
             // Prepend bid to front of Linked List
@@ -340,6 +589,10 @@ void searchMenu() {
                 cout << "Bid Prepended to Linked List" << endl;
                 printTime(ticks); // Method formats the time output
 
+                // keep the winning bid statistics up to date, outside the timing
+                loadAmounts(amounts);
+                amounts->Insert(bid);
+
                 break;
 
             // Search Binary Search Tree
@@ -402,6 +655,10 @@ void searchMenu() {
                 displayBid(bid);
                 printTime(ticks); // Method formats the time output
 
+                // keep the winning bid statistics up to date, outside the timing
+                loadAmounts(amounts);
+                amounts->Insert(bid);
+
                 break;
 
             // Search the Hash Table
@@ -451,11 +708,21 @@ void searchMenu() {
 
                 // Start point for clock ticks to count time
                 ticks = clock();
-                bidTable->Insert(bid);
+                try {
+                    bidTable->Insert(bid);
+                } catch (invalid_argument &e) {
+                    // the table is keyed on numeric ids
+                    cout << "!! " << e.what() << ", Please Try Again !!" << endl;
+                    break;
+                }
                 ticks = clock() - ticks;
                 cout << "Bid Added to Hash Table" << endl;
                 printTime(ticks); // Method formats the time output
 
+                // keep the winning bid statistics up to date, outside the timing
+                loadAmounts(amounts);
+                amounts->Insert(bid);
+
                 break;
 
             // Print data structures
@@ -495,6 +762,11 @@ void searchMenu() {
                 }
                 break;
 
+            // Winning bid statistics, kept current as bids are inserted
+            case 10:
+                showAmountStatistics(amounts);
+                break;
+
             // Return to Main Menu found in main()
             case 9:
                 break;
@@ -507,11 +779,1671 @@ void searchMenu() {
 
 }
 
+/**
+ * Write a larger copy of the CSV for the benchmarks by repeating its rows
+ * @param copies number of times the rows are repeated
+ * @return path to the generated CSV file
+ */
+string writeReplicatedCsv(int copies) {
+    ifstream in(csvPath);
+    string header, rows, line;
+    getline(in, header);
+    while (getline(in, line)) {
+        rows += line + '\n';
+    }
+
+    string path = string(P_tmpdir) + "/eBid_x" + to_string(copies) + ".csv";
+    ofstream out(path, ios::out | ios::trunc);
+    out << header << '\n';
+    for (int i = 0; i < copies; ++i) {
+        out << rows;
+    }
+    return path;
+}
+
+/**
+ * Stream a CSV with the csv::Reader and show how the memory in use
+ * compares to the size of the file being read
+ * @param path path to the CSV to stream
+ */
+void benchmarkReader(const string& path) {
+    malloc_trim(0);
+    long before = residentKilobytes();
+    long peak = 0;
+
+    ticks = clock();
+    csv::Reader file = csv::Reader(path);
+    unsigned int rows = file.forEach([&](const csv::Reader& row) {
+        // sample the resident memory every few thousand rows
+        if (row.rowNumber() % 4096 == 0) {
+            peak = max(peak, residentKilobytes() - before);
+        }
+    });
+    ticks = clock() - ticks;
+
+    ifstream size(path, ios::ate | ios::binary);
+    cout << rows << " rows streamed from a " << size.tellg() / 1024 << " KB file" << endl;
+    cout << "peak ";
+    printMemory(peak);
+    printTime(ticks); // Method formats the time output
+}
+
+/**
+ * Parse a replicated copy of the CSV with 1, 2, 4 and 8 threads and show
+ * the speedup of each over the single threaded parse
+ */
+void benchmarkParallelParser() {
+    string path = writeReplicatedCsv(20);
+    cout << "\nParsing " << path << " (" << thread::hardware_concurrency() << " cores available)" << endl;
+
+    double single = 0;
+    for (unsigned int threads : {1, 2, 4, 8}) {
+        double start = wallSeconds();
+        csv::Parser file = csv::Parser(path, csv::eMMAP, ',', threads);
+        double elapsed = wallSeconds() - start;
+        if (threads == 1) {
+            single = elapsed;
+        }
+        cout << threads << " thread(s): " << file.rowCount() << " rows in " << elapsed
+             << " seconds, speedup " << single / elapsed << "x" << endl;
+    }
+    cout << endl;
+    remove(path.c_str());
+}
+
+/**
+ * Run the CSV tokenizer over every line of the file with the scalar and
+ * the SIMD kernel and show the throughput of each
+ */
+void benchmarkTokenizer() {
+    const int passes = 50;
+    ifstream in(csvPath);
+    vector<string> lines;
+    string line;
+    size_t bytes = 0;
+    while (getline(in, line)) {
+        bytes += line.size();
+        lines.push_back(line);
+    }
+
+    cout << endl;
+    for (csv::Kernel kernel : {csv::eSCALAR, csv::eSIMD}) {
+        unsigned long fields = 0;
+
+        ticks = clock();
+        for (int pass = 0; pass < passes; ++pass) {
+            for (const string& text : lines) {
+                fields += csv::countFields(text.data(), text.size(), ',', kernel);
+            }
+        }
+        ticks = clock() - ticks;
+
+        double seconds = ticks * 1.0 / CLOCKS_PER_SEC;
+        cout << csv::kernelName(kernel) << ": " << fields / passes << " fields, "
+             << bytes * passes / seconds / 1e9 << " GB/s" << endl;
+        printTime(ticks); // Method formats the time output
+    }
+}
+
+/**
+ * Measure what every parsed row used to spend on its own copy of the
+ * header against the shared schema each row points to now
+ */
+void benchmarkSchema() {
+    csv::Parser file = csv::Parser(csvPath);
+    vector<string> header = file.getHeader();
+    unsigned int rows = file.rowCount();
+
+    // one header copy per row, the way csv::Row used to store it
+    malloc_trim(0);
+    long before = residentKilobytes();
+    vector<vector<string>> copies(rows, header);
+    long copied = residentKilobytes() - before;
+    copies.clear();
+    copies.shrink_to_fit();
+
+    // one shared schema referenced by every row
+    malloc_trim(0);
+    before = residentKilobytes();
+    shared_ptr<const csv::Schema> schema = make_shared<const csv::Schema>(header);
+    vector<shared_ptr<const csv::Schema>> shared(rows, schema);
+    long referenced = residentKilobytes() - before;
+
+    cout << "\n" << rows << " rows, " << header.size() << " columns" << endl;
+    cout << "Header copy per row:   " << copied * 1024.0 / rows << " bytes (" << copied << " KB)" << endl;
+    cout << "Shared schema per row: " << referenced * 1024.0 / rows << " bytes (" << referenced << " KB)" << endl;
+    cout << "Saved per row:         " << (copied - referenced) * 1024.0 / rows << " bytes\n" << endl;
+}
+
+/**
+ * Compare starting up from the CSV against starting up from a snapshot
+ */
+void benchmarkSnapshot() {
+    string path = string(P_tmpdir) + "/eBid_benchmark.bids";
+    BidSnapshot::Convert(csvPath, path);
+
+    cout << "\nCSV parse (VectorSort::loadBids)" << endl;
+    ticks = clock();
+    vector<Bid> bids = VectorSort::loadBids(csvPath);
+    ticks = clock() - ticks;
+    cout << bids.size() << " bids loaded" << endl;
+    printTime(ticks); // Method formats the time output
+
+    cout << "Snapshot map" << endl;
+    ticks = clock();
+    BidSnapshot snapshot(path);
+    Bid last = snapshot.GetBid(snapshot.Size() - 1);
+    ticks = clock() - ticks;
+    cout << snapshot.Size() << " bids mapped, last is " << last.bidId << endl;
+    printTime(ticks); // Method formats the time output
+
+    cout << "Snapshot map and build every bid" << endl;
+    ticks = clock();
+    bids = BidSnapshot(path).ToVector();
+    ticks = clock() - ticks;
+    cout << bids.size() << " bids loaded" << endl;
+    printTime(ticks); // Method formats the time output
+
+    remove(path.c_str());
+}
+
+/**
+ * Load the CSV into a container and show how many bids were copied on
+ * the way in and how many times its nodes went to the heap
+ * @param name label printed with the results
+ * @param load loads the CSV into a new container and destroys it
+ */
+template <typename Load>
+void countBidCopies(const string& name, Load load) {
+    size_t copiesBefore = Bid::copies.load();
+    size_t heapBefore = NodePoolCounters::heapAllocations.load();
+    double start = wallSeconds();
+    load();
+    double loadTime = wallSeconds() - start;
+    cout << name << ": " << Bid::copies.load() - copiesBefore << " bid copies, "
+         << NodePoolCounters::heapAllocations.load() - heapBefore << " node allocations, "
+         << loadTime * 1e3 << " ms" << endl;
+}
+
+/**
+ * Count the bids copied while loading the CSV into every container, a
+ * bid parsed by a loader should be moved all the way into its container
+ */
+void benchmarkBidCopies() {
+    cout << endl;
+    countBidCopies("Vector              ", [] { VectorSort::loadBids(csvPath); });
+    countBidCopies("Linked list         ", [] { LinkedList list; LinkedList::loadBids(csvPath, &list); });
+    countBidCopies("Binary search tree  ", [] { BinarySearchTree tree; BinarySearchTree::loadBids(csvPath, &tree); });
+    countBidCopies("  (bulk load)       ", [] { BinarySearchTree tree; BinarySearchTree::bulkLoadBids(csvPath, &tree); });
+    countBidCopies("B+ tree             ", [] { BPlusTree tree; BPlusTree::loadBids(csvPath, &tree); });
+    countBidCopies("  (bulk load)       ", [] { BPlusTree tree; BPlusTree::bulkLoadBids(csvPath, &tree); });
+    countBidCopies("Hash table          ", [] { HashTable table; HashTable::loadBids(csvPath, &table); });
+    countBidCopies("Concurrent hash     ", [] { ConcurrentHashTable table; ConcurrentHashTable::loadBids(csvPath, &table); });
+    countBidCopies("Concurrent skip list", [] { ConcurrentSkipList list; ConcurrentSkipList::loadBids(csvPath, &list); });
+    countBidCopies("Order statistic tree", [] { OrderStatisticTree tree; OrderStatisticTree::loadBids(csvPath, &tree); });
+    cout << endl;
+}
+
+/**
+ * Check the allocation-free currency and id parsers against the old
+ * conversions on every row of the CSV, then compare their speed
+ */
+void benchmarkConversions() {
+    const int passes = 50;
+    vector<string> amounts, ids;
+    csv::Reader file = csv::Reader(csvPath, csv::eMMAP, ',', BID_COLUMNS);
+    while (file.next()) {
+        amounts.push_back(string(file[AMOUNT]));
+        amounts.push_back(string(file[NET_SALES]));
+        ids.push_back(string(file[BID_ID]));
+        ids.push_back(string(file[RECEIPT_NUMBER]));
+    }
+
+    // every value must convert exactly as before
+    int mismatches = 0, numeric = 0;
+    for (const string& amount : amounts) {
+        if (currencyToDouble(amount) != strToDouble(amount, '$')) {
+            cout << "amount mismatch: " << amount << endl;
+            ++mismatches;
+        }
+    }
+    for (const string& id : ids) {
+        unsigned long long value;
+        bool parsed = parseUnsigned(id, value);
+        bool digits = !id.empty() && all_of(id.begin(), id.end(), ::isdigit);
+        if (parsed != digits || (parsed && value != stoull(id))) {
+            cout << "id mismatch: " << id << endl;
+            ++mismatches;
+        }
+        numeric += parsed;
+    }
+    cout << "\n" << amounts.size() << " amounts and " << ids.size() << " ids (" << numeric
+         << " numeric) checked, " << mismatches << " mismatches\n" << endl;
+
+    double sum = 0;
+    cout << "strToDouble and stoull" << endl;
+    ticks = clock();
+    for (int pass = 0; pass < passes; ++pass) {
+        for (const string& amount : amounts) {
+            sum += strToDouble(amount, '$');
+        }
+        for (const string& id : ids) {
+            if (!id.empty() && isdigit(id[0])) {
+                sum += stoull(id);
+            }
+        }
+    }
+    ticks = clock() - ticks;
+    printTime(ticks); // Method formats the time output
+
+    cout << "parseCents and parseUnsigned" << endl;
+    ticks = clock();
+    for (int pass = 0; pass < passes; ++pass) {
+        for (const string& amount : amounts) {
+            long long cents;
+            if (parseCents(amount, cents)) {
+                sum += cents;
+            }
+        }
+        for (const string& id : ids) {
+            unsigned long long value;
+            if (parseUnsigned(id, value)) {
+                sum += value;
+            }
+        }
+    }
+    ticks = clock() - ticks;
+    printTime(ticks); // Method formats the time output
+
+    // keep the loops from being optimized away
+    if (sum == 0) {
+        cout << endl;
+    }
+}
+
+/**
+ * Whether two bids hold the same values
+ */
+bool sameBid(const Bid& a, const Bid& b) {
+    return a.bidId == b.bidId && a.title == b.title && a.fund == b.fund && a.datePaid == b.datePaid
+           && a.receiptNumber == b.receiptNumber && a.amount == b.amount && a.netSales == b.netSales;
+}
+
+/**
+ * Compare the memory each bid takes as a Bid and as a CompactBid, and
+ * check that every compact bid expands back to the bid it came from
+ */
+void benchmarkCompactBids() {
+    malloc_trim(0);
+    long before = residentKilobytes();
+    vector<Bid> bids = VectorSort::loadBids(csvPath);
+    long bidMemory = residentKilobytes() - before;
+
+    malloc_trim(0);
+    before = residentKilobytes();
+    BidDictionary dictionary;
+    vector<CompactBid> compact = BidDictionary::loadBids(csvPath, dictionary);
+    long compactMemory = residentKilobytes() - before;
+
+    // the strings a Bid keeps outside of itself
+    size_t heap = 0;
+    for (const Bid& bid : bids) {
+        for (const string* text : {&bid.bidId, &bid.title, &bid.fund, &bid.datePaid, &bid.receiptNumber}) {
+            if (text->capacity() > string().capacity()) {
+                heap += text->capacity() + 1;
+            }
+        }
+    }
+
+    int mismatches = 0;
+    for (size_t i = 0; i < bids.size(); ++i) {
+        if (!sameBid(dictionary.Expand(compact[i]), bids[i])) {
+            ++mismatches;
+        }
+    }
+
+    size_t n = bids.size();
+    cout << "\n" << n << " bids, " << mismatches << " differ after Compact and Expand" << endl;
+    cout << "Bid:        " << sizeof(Bid) << " bytes + " << heap / n << " bytes of strings = "
+         << sizeof(Bid) + heap / n << " bytes per bid" << endl;
+    cout << "CompactBid: " << sizeof(CompactBid) << " bytes + " << dictionary.Bytes() / n
+         << " bytes of dictionary = " << sizeof(CompactBid) + dictionary.Bytes() / n << " bytes per bid" << endl;
+    cout << "Resident:   " << bidMemory * 1024 / n << " bytes per Bid, "
+         << compactMemory * 1024 / n << " bytes per CompactBid\n" << endl;
+}
+
+/**
+ * Load the CSV bids into a container holding Bid and into one holding
+ * CompactBid, show the resident memory each takes per bid and count the
+ * lookups where the two hand back different bids
+ * @param name label printed with the results
+ * @param count number of bids in the CSV
+ * @param search looks up a bid id in either container
+ * @param keys bid ids to look up
+ */
+template <template <typename> class Container, typename Search>
+void benchmarkRecords(const string& name, size_t count, Search search, const vector<string>& keys) {
+    malloc_trim(0);
+    long before = residentKilobytes();
+    Container<Bid>* bids = new Container<Bid>();
+    Container<Bid>::loadBids(csvPath, bids);
+    long bidMemory = residentKilobytes() - before;
+
+    malloc_trim(0);
+    before = residentKilobytes();
+    Container<CompactBid>* compact = new Container<CompactBid>();
+    Container<CompactBid>::loadBids(csvPath, compact);
+    long compactMemory = residentKilobytes() - before;
+
+    int mismatches = 0;
+    for (const string& key : keys) {
+        if (!sameBid(search(bids, key), search(compact, key))) {
+            ++mismatches;
+        }
+    }
+    delete bids;
+    delete compact;
+
+    cout << name << ": " << bidMemory * 1024 / count << " bytes per Bid, "
+         << compactMemory * 1024 / count << " bytes per CompactBid, "
+         << mismatches << " of " << keys.size() << " lookups differ" << endl;
+}
+
+/**
+ * Compare the resident memory of every container holding Bid and holding
+ * CompactBid. The compact containers share one dictionary, which is
+ * filled before they are measured and reported on its own.
+ */
+void benchmarkContainerRecords() {
+    vector<Bid> csvBids = VectorSort::loadBids(csvPath);
+    size_t n = csvBids.size();
+    if (n == 0) {
+        return;
+    }
+    for (const Bid& bid : csvBids) {
+        packBid<CompactBid>(bid);
+    }
+    // the linked list walks its blocks on every lookup, so only look up a sample
+    vector<string> keys;
+    for (size_t i = 0; i < n; i += max<size_t>(1, n / 1000)) {
+        keys.push_back(csvBids[i].bidId);
+    }
+    vector<Bid>().swap(csvBids);
+
+    cout << "\n" << n << " bids, shared dictionary " << SharedBidDictionary::Bytes() / n
+         << " bytes per bid" << endl;
+    auto search = [](auto* container, const string& key) { return container->Search(key); };
+    benchmarkRecords<LinkedListOf>("Linked list          ", n, search, keys);
+    benchmarkRecords<BinarySearchTreeOf>("Binary search tree   ", n, search, keys);
+    benchmarkRecords<HashTableOf>("Hash table           ", n, search, keys);
+    benchmarkRecords<BPlusTreeOf>("B+ tree              ", n, search, keys);
+    benchmarkRecords<ConcurrentHashTableOf>("Concurrent hash      ", n, search, keys);
+    benchmarkRecords<ConcurrentSkipListOf>("Concurrent skip list ", n, search, keys);
+    // looked up by rank, the tree is ordered by amount rather than id
+    benchmarkRecords<OrderStatisticTreeOf>("Order statistic tree ", n,
+        [](auto* tree, const string& key) { return tree->Select(stoul(key) % tree->Count()); }, keys);
+    cout << endl;
+}
+
+/**
+ * Compare the copying parser against the memory mapped parser
+ */
+void benchmarkMappedParser() {
+    cout << endl;
+    benchmarkParser(csv::eMMAP, "Memory mapped (eMMAP)");
+    benchmarkParser(csv::eFILE, "Copying (eFILE)");
+}
+
+/**
+ * Show the streaming reader's memory stays flat as files grow
+ */
+void benchmarkStreaming() {
+    cout << endl;
+    for (int copies : {1, 10, 40}) {
+        string path = writeReplicatedCsv(copies);
+        benchmarkReader(path);
+        remove(path.c_str());
+    }
+}
+
+/**
+ * Compare decoding every column against the projected bid columns
+ */
+void benchmarkProjection() {
+    cout << endl;
+    benchmarkParser(csv::eFILE, "All columns");
+    benchmarkParser(csv::eFILE, "Bid columns only", BID_COLUMNS);
+}
+
+/**
+ * Build a made up bid for the benchmarks that need more bids than the CSV holds
+ * @param id numeric id of the bid
+ * @return a bid with short fields, so the strings stay inside the Bid
+ */
+Bid syntheticBid(unsigned int id) {
+    Bid bid;
+    bid.bidId = to_string(id);
+    bid.title = "Lot " + to_string(id % 100000);
+    bid.fund = id % 2 ? "Enterprise" : "General Fund";
+    bid.amount = (id % 10000) / 100.0;
+    return bid;
+}
+
+/**
+ * Time lookups of random keys in a hash table
+ * @param table the table to search
+ * @param keys bid ids to look up
+ * @return average nanoseconds per lookup
+ */
+double timeHashLookups(HashTable& table, const vector<string>& keys) {
+    size_t found = 0;
+    double start = wallSeconds();
+    for (const string& key : keys) {
+        found += !table.Search(key).bidId.empty();
+    }
+    double elapsed = wallSeconds() - start;
+    // keep the lookups from being optimized away
+    if (found > keys.size()) {
+        cout << found;
+    }
+    return elapsed * 1e9 / keys.size();
+}
+
+/**
+ * Show hit and miss lookup latency of the hash table as it grows past
+ * the size of the CSV. Bids get even ids so every odd id is a miss.
+ */
+void benchmarkHashLookups() {
+    cout << endl;
+    mt19937 random(42);
+    for (unsigned int size : {17937u, 1000000u, 10000000u}) {
+        malloc_trim(0);
+        long before = residentKilobytes();
+
+        // sized up front so no rehash lands inside the timing
+        HashTable* table = new HashTable(size);
+        double start = wallSeconds();
+        for (unsigned int i = 0; i < size; ++i) {
+            table->Insert(syntheticBid(2 * i));
+        }
+        double insertTime = wallSeconds() - start;
+        long memory = residentKilobytes() - before;
+
+        vector<string> hits, misses;
+        for (int i = 0; i < 1000000; ++i) {
+            unsigned int id = random() % size;
+            hits.push_back(to_string(2 * id));
+            misses.push_back(to_string(2 * id + 1));
+        }
+
+        double hitTime = timeHashLookups(*table, hits);
+        double missTime = timeHashLookups(*table, misses);
+        cout << table->Count() << " bids in " << table->Capacity() << " slots" << endl;
+        cout << "insert: " << insertTime * 1e9 / size << " ns per bid" << endl;
+        cout << "hit:    " << hitTime << " ns per lookup" << endl;
+        cout << "miss:   " << missTime << " ns per lookup" << endl;
+        printMemory(memory);
+        cout << endl;
+        delete table;
+    }
+}
+
+/**
+ * Compare single lookups against SearchBatch at a few batch sizes on a
+ * table far larger than the CPU caches
+ */
+void benchmarkSearchBatch() {
+    const unsigned int size = 10000000;
+    HashTable* table = new HashTable(size);
+    for (unsigned int i = 0; i < size; ++i) {
+        table->Insert(syntheticBid(i));
+    }
+
+    // one id in eight is a miss
+    mt19937 random(42);
+    vector<string> keys;
+    for (int i = 0; i < 1000000; ++i) {
+        keys.push_back(to_string(random() % (size + size / 7)));
+    }
+
+    cout << right << "\n" << size << " bids, " << keys.size() << " lookups" << endl;
+    double start = wallSeconds();
+    vector<Bid> expected;
+    expected.reserve(keys.size());
+    for (const string& key : keys) {
+        expected.push_back(table->Search(key));
+    }
+    cout << "Search:          " << (wallSeconds() - start) * 1e9 / keys.size() << " ns per lookup" << endl;
+
+    vector<Bid> results(keys.size());
+    for (size_t batch : {1, 16, 256}) {
+        start = wallSeconds();
+        for (size_t first = 0; first < keys.size(); first += batch) {
+            table->SearchBatch(&keys[first], min(batch, keys.size() - first), &results[first]);
+        }
+        double elapsed = wallSeconds() - start;
+
+        int mismatches = 0;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            mismatches += results[i].bidId != expected[i].bidId;
+        }
+        cout << "SearchBatch " << setw(3) << batch << ": " << elapsed * 1e9 / keys.size()
+             << " ns per lookup, " << mismatches << " differ from Search" << endl;
+    }
+    cout << endl;
+    delete table;
+}
+
+/**
+ * Search the concurrent hash table from several threads while another
+ * thread loads, removes and reloads the CSV bids, and check that every
+ * read sees a whole bid that was really inserted under that id
+ */
+void stressConcurrentHashTable() {
+    vector<Bid> bids = VectorSort::loadBids(csvPath);
+    unordered_map<string, vector<string>> titles;
+    for (const Bid& bid : bids) {
+        titles[bid.bidId].push_back(bid.title);
+    }
+
+    // start small so the shards grow while they are being read
+    ConcurrentHashTable table(64);
+    atomic<bool> done(false);
+    atomic<long> reads(0), found(0), inconsistent(0);
+
+    auto reader = [&](unsigned int seed) {
+        mt19937 random(seed);
+        while (!done.load()) {
+            const string& bidId = bids[random() % bids.size()].bidId;
+            Bid bid = table.Search(bidId);
+            reads++;
+            if (bid.bidId.empty()) {
+                continue;
+            }
+            found++;
+            const vector<string>& expected = titles[bidId];
+            if (bid.bidId != bidId || find(expected.begin(), expected.end(), bid.title) == expected.end()) {
+                inconsistent++;
+            }
+        }
+    };
+
+    unsigned int readers = max(2u, thread::hardware_concurrency());
+    vector<thread> threads;
+    double start = wallSeconds();
+    for (unsigned int i = 0; i < readers; ++i) {
+        threads.emplace_back(reader, i + 1);
+    }
+
+    // load everything, take every other bid back out, then put them back
+    for (const Bid& bid : bids) {
+        table.Insert(bid);
+    }
+    for (size_t i = 0; i < bids.size(); i += 2) {
+        table.Remove(bids[i].bidId);
+    }
+    for (size_t i = 0; i < bids.size(); i += 2) {
+        table.Insert(bids[i]);
+    }
+    done = true;
+    for (thread& t : threads) {
+        t.join();
+    }
+    double elapsed = wallSeconds() - start;
+
+    int missing = 0;
+    for (const Bid& bid : bids) {
+        if (table.Search(bid.bidId).bidId != bid.bidId) {
+            missing++;
+        }
+    }
+
+    cout << "\n" << readers << " readers made " << reads << " searches (" << found << " found) in "
+         << elapsed << " seconds while 1 writer made " << bids.size() * 2 << " changes" << endl;
+    cout << inconsistent << " inconsistent reads" << endl;
+    cout << table.Count() << " bids in table, " << titles.size() << " expected, "
+         << missing << " missing\n" << endl;
+}
+
+/**
+ * Run a mix of searches and changes on a container from a number of threads
+ * @param search looks up a bid id
+ * @param insert adds a bid
+ * @param remove removes a bid id
+ * @param keys bid ids to pick from, half of them in the container
+ * @param threadCount number of threads to share the operations
+ * @param writePercent percentage of operations that change the container
+ * @return millions of operations per second
+ */
+template <typename Search, typename Insert, typename Remove>
+double runMixedWorkload(Search search, Insert insert, Remove remove, const vector<Bid>& keys,
+                       unsigned int threadCount, unsigned int writePercent) {
+    const long operations = 2000000;
+    vector<thread> threads;
+    double start = wallSeconds();
+    for (unsigned int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t]() {
+            mt19937 random(t + 1);
+            for (long i = 0; i < operations / threadCount; ++i) {
+                const Bid& bid = keys[random() % keys.size()];
+                unsigned int roll = random() % 100;
+                if (roll >= writePercent) {
+                    search(bid.bidId);
+                } else if (roll % 2 == 0) {
+                    insert(bid);
+                } else {
+                    remove(bid.bidId);
+                }
+            }
+        });
+    }
+    for (thread& t : threads) {
+        t.join();
+    }
+    return operations / (wallSeconds() - start) / 1e6;
+}
+
+/**
+ * Compare the concurrent hash table against the hash table behind a
+ * single lock, with read-heavy and write-heavy mixes over 1-8 threads
+ */
+void benchmarkConcurrentHashTable() {
+    const unsigned int size = 100000;
+    vector<Bid> keys;
+    for (unsigned int i = 0; i < 2 * size; ++i) {
+        keys.push_back(syntheticBid(i));
+    }
+
+    cout << "\n" << thread::hardware_concurrency() << " hardware threads, " << size
+         << " bids, million operations per second" << endl;
+    cout << right << "writes  threads  HashTable+mutex  ConcurrentHashTable" << endl;
+    for (unsigned int writePercent : {5u, 50u}) {
+        for (unsigned int threadCount : {1u, 2u, 4u, 8u}) {
+            HashTable locked(2 * size);
+            mutex lock;
+            ConcurrentHashTable sharded(2 * size);
+            for (unsigned int i = 0; i < 2 * size; i += 2) {
+                locked.Insert(keys[i]);
+                sharded.Insert(keys[i]);
+            }
+
+            double lockedRate = runMixedWorkload(
+                    [&](const string& bidId) { lock_guard<mutex> guard(lock); return locked.Search(bidId); },
+                    [&](const Bid& bid) { lock_guard<mutex> guard(lock); locked.Insert(bid); },
+                    [&](const string& bidId) { lock_guard<mutex> guard(lock); locked.Remove(bidId); },
+                    keys, threadCount, writePercent);
+            double shardedRate = runMixedWorkload(
+                    [&](const string& bidId) { return sharded.Search(bidId); },
+                    [&](const Bid& bid) { sharded.Insert(bid); },
+                    [&](const string& bidId) { sharded.Remove(bidId); },
+                    keys, threadCount, writePercent);
+
+            cout << setw(5) << writePercent << "%  " << setw(7) << threadCount << "  "
+                 << setw(15) << lockedRate << "  " << setw(19) << shardedRate << endl;
+        }
+    }
+    cout << endl;
+}
+
+/**
+ * Load a set of bids into a binary search tree in the order given and
+ * show its height along with the time to load it and search every bid
+ * @param name label printed with the results
+ * @param bids the bids to load
+ */
+void benchmarkTreeLoad(const string& name, const vector<Bid>& bids) {
+    BinarySearchTree* bst = new BinarySearchTree();
+    double start = wallSeconds();
+    for (const Bid& bid : bids) {
+        bst->Insert(bid);
+    }
+    double loadTime = wallSeconds() - start;
+
+    size_t found = 0;
+    start = wallSeconds();
+    for (const Bid& bid : bids) {
+        found += bst->Search(bid.bidId).bidId == bid.bidId;
+    }
+    double searchTime = wallSeconds() - start;
+
+    cout << name << ": height " << bst->Height() << ", load " << loadTime * 1e9 / bids.size()
+         << " ns per bid, search " << searchTime * 1e9 / bids.size() << " ns per bid ("
+         << found << " of " << bids.size() << " found)" << endl;
+    delete bst;
+}
+
+/**
+ * Compare the balanced binary search tree on bids in CSV order, sorted
+ * and shuffled, for the CSV and for 1M synthetic bids
+ */
+void benchmarkTreeBalance() {
+    cout << endl;
+    mt19937 random(42);
+    vector<Bid> bids = VectorSort::loadBids(csvPath);
+    benchmarkTreeLoad("CSV order      ", bids);
+    sort(bids.begin(), bids.end(), [](const Bid& a, const Bid& b) { return a.bidId < b.bidId; });
+    benchmarkTreeLoad("CSV sorted     ", bids);
+    shuffle(bids.begin(), bids.end(), random);
+    benchmarkTreeLoad("CSV shuffled   ", bids);
+
+    // fixed width ids so string order matches number order
+    vector<Bid> synthetic;
+    for (unsigned int i = 0; i < 1000000; ++i) {
+        synthetic.push_back(syntheticBid(10000000 + i));
+    }
+    benchmarkTreeLoad("1M sorted      ", synthetic);
+    shuffle(synthetic.begin(), synthetic.end(), random);
+    benchmarkTreeLoad("1M shuffled    ", synthetic);
+    cout << endl;
+}
+
+/**
+ * Load bids into a tree and show the memory it takes and the time to
+ * load it and look up a set of bid ids
+ * @param name label printed with the results
+ * @param tree an empty tree, deleted once it has been measured
+ * @param count number of bids to load
+ * @param bidAt gives the bid to load at each position
+ * @param keys bid ids to look up
+ */
+template <typename Tree, typename Generator>
+void benchmarkIndex(const string& name, Tree* tree, unsigned int count, Generator bidAt,
+                    const vector<string>& keys) {
+    malloc_trim(0);
+    long before = residentKilobytes();
+    double start = wallSeconds();
+    for (unsigned int i = 0; i < count; ++i) {
+        tree->Insert(bidAt(i));
+    }
+    double loadTime = wallSeconds() - start;
+    long memory = residentKilobytes() - before;
+
+    size_t found = 0;
+    start = wallSeconds();
+    for (const string& key : keys) {
+        found += !tree->Search(key).bidId.empty();
+    }
+    double searchTime = wallSeconds() - start;
+
+    cout << name << ": height " << tree->Height() << ", load " << loadTime * 1e9 / count
+         << " ns per bid, search " << searchTime * 1e9 / keys.size() << " ns per lookup ("
+         << found << " found), " << memory / 1024 << " MB resident" << endl;
+    delete tree;
+}
+
+/**
+ * Compare the B+tree against the binary search tree on the CSV and on
+ * 10M synthetic bids inserted in scrambled order, then time range scans
+ */
+void benchmarkBPlusTree() {
+    mt19937 random(42);
+    vector<Bid> bids = VectorSort::loadBids(csvPath);
+    vector<string> keys;
+    for (int i = 0; i < 1000000; ++i) {
+        keys.push_back(bids[random() % bids.size()].bidId);
+    }
+
+    cout << "\nCSV, " << bids.size() << " bids" << endl;
+    auto csvBid = [&](unsigned int i) { return bids[i]; };
+    benchmarkIndex("Binary search tree", new BinarySearchTree(), bids.size(), csvBid, keys);
+    benchmarkIndex("B+tree            ", new BPlusTree(), bids.size(), csvBid, keys);
+
+    // every id from 10000000 visited once in a scrambled order, fixed width
+    // ids so the binary search tree's string order matches number order
+    const unsigned int size = 10000000;
+    auto syntheticAt = [&](unsigned int i) { return syntheticBid(10000000 + (i * 7919ull) % size); };
+    keys.clear();
+    for (int i = 0; i < 1000000; ++i) {
+        keys.push_back(to_string(10000000 + random() % size));
+    }
+
+    cout << "\n" << size << " synthetic bids" << endl;
+    benchmarkIndex("Binary search tree", new BinarySearchTree(), size, syntheticAt, keys);
+
+    BPlusTree* tree = new BPlusTree();
+    for (unsigned int i = 0; i < size; ++i) {
+        tree->Insert(syntheticAt(i));
+    }
+    size_t visited = 0;
+    double total = 0;
+    double start = wallSeconds();
+    for (int i = 0; i < 1000; ++i) {
+        unsigned int first = 10000000 + random() % size;
+        tree->Range(first, first + 9999, [&](const Bid& bid) { total += bid.amount; visited++; });
+    }
+    double rangeTime = wallSeconds() - start;
+    delete tree;
+
+    benchmarkIndex("B+tree            ", new BPlusTree(), size, syntheticAt, keys);
+    cout << "B+tree range scans: 1000 ranges of 10000 ids, " << visited << " bids visited, "
+         << rangeTime * 1e9 / visited << " ns per bid (total $" << total << ")\n" << endl;
+}
+
+/**
+ * Load a set of bids into a tree with Insert and then with BulkLoad and
+ * show the time each takes and the height of the tree it gives
+ * @param name label printed with the results
+ * @param bids the bids to load, in the order given
+ */
+template <typename Tree>
+void benchmarkBulkLoad(const string& name, const vector<Bid>& bids) {
+    Tree* tree = new Tree();
+    double start = wallSeconds();
+    for (const Bid& bid : bids) {
+        tree->Insert(bid);
+    }
+    double insertTime = wallSeconds() - start;
+    int insertHeight = tree->Height();
+    delete tree;
+
+    // the copy BulkLoad consumes is made outside the timing
+    vector<Bid> copy = bids;
+    tree = new Tree();
+    start = wallSeconds();
+    tree->BulkLoad(move(copy));
+    double bulkTime = wallSeconds() - start;
+
+    cout << name << ": Insert " << insertTime * 1e3 << " ms (height " << insertHeight << "), BulkLoad "
+         << bulkTime * 1e3 << " ms (height " << tree->Height() << ")" << endl;
+    delete tree;
+}
+
+/**
+ * Compare loading the trees one bid at a time against building them in
+ * one pass, for sorted input and for input that has to be sorted first
+ */
+void benchmarkBulkLoads() {
+    mt19937 random(42);
+    vector<Bid> csvOrder = VectorSort::loadBids(csvPath);
+    vector<Bid> sorted = csvOrder;
+    sort(sorted.begin(), sorted.end(), [](const Bid& a, const Bid& b) { return a.bidId < b.bidId; });
+    vector<Bid> shuffled = sorted;
+    shuffle(shuffled.begin(), shuffled.end(), random);
+
+    // fixed width ids so string order matches number order
+    vector<Bid> syntheticSorted;
+    for (unsigned int i = 0; i < 1000000; ++i) {
+        syntheticSorted.push_back(syntheticBid(10000000 + i));
+    }
+    vector<Bid> syntheticShuffled = syntheticSorted;
+    shuffle(syntheticShuffled.begin(), syntheticShuffled.end(), random);
+
+    cout << "\nBinary search tree" << endl;
+    benchmarkBulkLoad<BinarySearchTree>("  CSV order   ", csvOrder);
+    benchmarkBulkLoad<BinarySearchTree>("  CSV sorted  ", sorted);
+    benchmarkBulkLoad<BinarySearchTree>("  CSV shuffled", shuffled);
+    benchmarkBulkLoad<BinarySearchTree>("  1M sorted   ", syntheticSorted);
+    benchmarkBulkLoad<BinarySearchTree>("  1M shuffled ", syntheticShuffled);
+    cout << "B+tree" << endl;
+    benchmarkBulkLoad<BPlusTree>("  CSV order   ", csvOrder);
+    benchmarkBulkLoad<BPlusTree>("  CSV sorted  ", sorted);
+    benchmarkBulkLoad<BPlusTree>("  CSV shuffled", shuffled);
+    benchmarkBulkLoad<BPlusTree>("  1M sorted   ", syntheticSorted);
+    benchmarkBulkLoad<BPlusTree>("  1M shuffled ", syntheticShuffled);
+    cout << endl;
+}
+
+/**
+ * Show the time to load the linked list from the CSV and from larger
+ * copies of it, and to search the whole list for an id it doesn't hold
+ */
+void benchmarkLinkedList() {
+    cout << endl;
+    for (int copies : {1, 10, 40}) {
+        string path = copies == 1 ? csvPath : writeReplicatedCsv(copies);
+        LinkedList* list = new LinkedList();
+
+        double start = wallSeconds();
+        LinkedList::loadBids(path, list);
+        double loadTime = wallSeconds() - start;
+
+        start = wallSeconds();
+        bool found = !list->Search("0").bidId.empty();
+        double searchTime = wallSeconds() - start;
+
+        cout << list->Size() << " bids: load " << loadTime * 1e3 << " ms ("
+             << loadTime * 1e9 / list->Size() << " ns per bid), full search "
+             << searchTime * 1e3 << " ms" << (found ? "" : " (not found)") << endl;
+        delete list;
+        if (copies != 1) {
+            remove(path.c_str());
+        }
+    }
+    cout << endl;
+}
+
+/**
+ * Load a container with its nodes on the heap and then from a node pool
+ * and show the time to load, search and destroy it, the memory it takes
+ * and how many times it went to the heap for nodes
+ * @param name label printed with the results
+ * @param count number of bids to load
+ * @param insert adds the bid at a position to the container
+ * @param search looks up a bid id in the container
+ * @param keys bid ids to look up
+ */
+template <typename Container, typename Insert, typename Search>
+void benchmarkNodePool(const string& name, unsigned int count, Insert insert, Search search,
+                       const vector<string>& keys) {
+    for (bool pooled : {false, true}) {
+        NodePoolCounters::enabled = pooled;
+        malloc_trim(0);
+        long before = residentKilobytes();
+        size_t heapBefore = NodePoolCounters::heapAllocations.load();
+
+        double start = wallSeconds();
+        Container* container = new Container();
+        for (unsigned int i = 0; i < count; ++i) {
+            insert(container, i);
+        }
+        double loadTime = wallSeconds() - start;
+        long memory = residentKilobytes() - before;
+        size_t heapAllocations = NodePoolCounters::heapAllocations.load() - heapBefore;
+
+        size_t found = 0;
+        start = wallSeconds();
+        for (const string& key : keys) {
+            found += !search(container, key).bidId.empty();
+        }
+        double searchTime = wallSeconds() - start;
+
+        start = wallSeconds();
+        delete container;
+        double destroyTime = wallSeconds() - start;
+
+        cout << name << (pooled ? " pooled: " : " heap:   ") << "load " << loadTime * 1e9 / count
+             << " ns per bid, search " << searchTime * 1e9 / keys.size() << " ns per lookup ("
+             << found << " found), destroy " << destroyTime * 1e3 << " ms, "
+             << memory / 1024 << " MB resident, " << heapAllocations << " node allocations" << endl;
+    }
+    NodePoolCounters::enabled = true;
+}
+
+/**
+ * Compare the node based containers with and without node pools on 1M
+ * synthetic bids, the linked list only gets a few lookups since each one
+ * walks the list
+ */
+void benchmarkNodePools() {
+    const unsigned int size = 1000000;
+    mt19937 random(42);
+    // fixed width ids so the binary search tree's string order matches number order
+    auto bidAt = [](unsigned int i) { return syntheticBid(10000000 + (i * 7919ull) % size); };
+    vector<string> keys;
+    for (int i = 0; i < 1000000; ++i) {
+        keys.push_back(to_string(10000000 + random() % size));
+    }
+    vector<string> listKeys(keys.begin(), keys.begin() + 20);
+
+    cout << "\n" << size << " synthetic bids" << endl;
+    benchmarkNodePool<LinkedList>("Linked list         ", size,
+        [&](LinkedList* list, unsigned int i) { list->Append(bidAt(i)); },
+        [](LinkedList* list, const string& key) { return list->Search(key); }, listKeys);
+    benchmarkNodePool<BinarySearchTree>("Binary search tree  ", size,
+        [&](BinarySearchTree* tree, unsigned int i) { tree->Insert(bidAt(i)); },
+        [](BinarySearchTree* tree, const string& key) { return tree->Search(key); }, keys);
+    benchmarkNodePool<ConcurrentHashTable>("Concurrent hash     ", size,
+        [&](ConcurrentHashTable* table, unsigned int i) { table->Insert(bidAt(i)); },
+        [](ConcurrentHashTable* table, const string& key) { return table->Search(key); }, keys);
+    // searched by rank, the tree is ordered by amount rather than id
+    benchmarkNodePool<OrderStatisticTree>("Order statistic tree", size,
+        [&](OrderStatisticTree* tree, unsigned int i) { tree->Insert(bidAt(i)); },
+        [](OrderStatisticTree* tree, const string& key) { return tree->Select(stoul(key) % tree->Count()); },
+        keys);
+    cout << endl;
+}
+
+/**
+ * Insert and remove the CSV bids from several threads while other threads
+ * walk the skip list in order and search it, and check that every walk
+ * is in order, every bid read is whole and the list ends up holding
+ * exactly the CSV bids
+ */
+void stressConcurrentSkipList() {
+    // one bid per id, the last one in the file wins
+    map<unsigned int, Bid> unique;
+    for (const Bid& bid : VectorSort::loadBids(csvPath)) {
+        unique[ConcurrentSkipList::getStringKey(bid.bidId)] = bid;
+    }
+    vector<Bid> bids;
+    for (auto& entry : unique) {
+        bids.push_back(entry.second);
+    }
+
+    ConcurrentSkipList list;
+    atomic<bool> done(false);
+    atomic<long> scans(0), searches(0), inconsistent(0);
+    unsigned long freedBefore = EpochReclaimer::Freed();
+
+    auto reader = [&](unsigned int seed) {
+        mt19937 random(seed);
+        while (!done.load()) {
+            long previous = -1;
+            list.Range(0, UINT_MAX, [&](const Bid& bid) {
+                long key = ConcurrentSkipList::getStringKey(bid.bidId);
+                if (key <= previous || unique.at(key).title != bid.title) {
+                    inconsistent++;
+                }
+                previous = key;
+            });
+            scans++;
+            for (int i = 0; i < 1000; ++i) {
+                const Bid& expected = bids[random() % bids.size()];
+                Bid bid = list.Search(expected.bidId);
+                if (!bid.bidId.empty() && (bid.bidId != expected.bidId || bid.title != expected.title)) {
+                    inconsistent++;
+                }
+                searches++;
+            }
+        }
+    };
+
+    // each writer owns every writers-th bid, adding them all on even
+    // rounds and taking them all out on odd rounds, ending with them in
+    const unsigned int writers = 2;
+    const int rounds = 21;
+    auto writer = [&](unsigned int first) {
+        for (int round = 0; round < rounds; ++round) {
+            for (size_t i = first; i < bids.size(); i += writers) {
+                bool changed = round % 2 == 0 ? list.Insert(bids[i]) : list.Remove(bids[i].bidId);
+                if (!changed) {
+                    inconsistent++;
+                }
+            }
+        }
+    };
+
+    double start = wallSeconds();
+    vector<thread> readers, writing;
+    for (unsigned int i = 0; i < 2; ++i) {
+        readers.emplace_back(reader, i + 1);
+    }
+    for (unsigned int i = 0; i < writers; ++i) {
+        writing.emplace_back(writer, i);
+    }
+    for (thread& t : writing) {
+        t.join();
+    }
+    done = true;
+    for (thread& t : readers) {
+        t.join();
+    }
+    double elapsed = wallSeconds() - start;
+
+    // every reader and writer has left, so everything retired can go
+    EpochReclaimer::Collect();
+    size_t walked = 0, missing = 0;
+    long previous = -1;
+    list.Range(0, UINT_MAX, [&](const Bid& bid) {
+        long key = ConcurrentSkipList::getStringKey(bid.bidId);
+        if (key <= previous) {
+            inconsistent++;
+        }
+        previous = key;
+        walked++;
+    });
+    for (const Bid& bid : bids) {
+        if (list.Search(bid.bidId).title != bid.title) {
+            missing++;
+        }
+    }
+
+    size_t changes = bids.size() * rounds;
+    cout << "\n2 readers made " << scans << " ordered walks and " << searches << " searches in "
+         << elapsed << " seconds while " << writers << " writers made " << changes << " changes" << endl;
+    cout << inconsistent << " inconsistent reads or changes" << endl;
+    cout << list.Count() << " bids in list, " << walked << " walked in order, " << bids.size()
+         << " expected, " << missing << " missing" << endl;
+    cout << EpochReclaimer::Freed() - freedBefore << " removed nodes freed, "
+         << bids.size() * (rounds / 2) << " removed\n" << endl;
+}
+
+/**
+ * Compare the lock-free skip list against the binary search tree behind
+ * a single lock, with read-heavy and write-heavy mixes over 1-8 threads
+ */
+void benchmarkConcurrentSkipList() {
+    const unsigned int size = 100000;
+    vector<Bid> keys;
+    for (unsigned int i = 0; i < 2 * size; ++i) {
+        keys.push_back(syntheticBid(i));
+    }
+
+    cout << right << "\n" << thread::hardware_concurrency() << " hardware threads, " << size
+         << " bids, million operations per second" << endl;
+    cout << "writes  threads  BinarySearchTree+mutex  ConcurrentSkipList" << endl;
+    for (unsigned int writePercent : {10u, 50u}) {
+        for (unsigned int threadCount : {1u, 2u, 4u, 8u}) {
+            BinarySearchTree locked;
+            mutex lock;
+            ConcurrentSkipList skipList;
+            for (unsigned int i = 0; i < 2 * size; i += 2) {
+                locked.Insert(keys[i]);
+                skipList.Insert(keys[i]);
+            }
+
+            double lockedRate = runMixedWorkload(
+                    [&](const string& bidId) { lock_guard<mutex> guard(lock); return locked.Search(bidId); },
+                    [&](const Bid& bid) { lock_guard<mutex> guard(lock); locked.Insert(bid); },
+                    [&](const string& bidId) { lock_guard<mutex> guard(lock); locked.Remove(bidId); },
+                    keys, threadCount, writePercent);
+            double skipListRate = runMixedWorkload(
+                    [&](const string& bidId) { return skipList.Search(bidId); },
+                    [&](const Bid& bid) { skipList.Insert(bid); },
+                    [&](const string& bidId) { skipList.Remove(bidId); },
+                    keys, threadCount, writePercent);
+
+            cout << setw(5) << writePercent << "%  " << setw(7) << threadCount << "  "
+                 << setw(22) << lockedRate << "  " << setw(18) << skipListRate << endl;
+        }
+    }
+    cout << endl;
+}
+
+/**
+ * Time sorting copies of the CSV bids on title a number of times, and
+ * check the sort gives the same titles in the same order as expected
+ * @param name label printed with the results
+ * @param bids the unsorted bids
+ * @param expected the titles in sorted order
+ * @param sortBids sorts a copy of the bids and gives the title at each place
+ */
+template <typename Sort>
+void timeTitleSort(const string& name, const vector<Bid>& bids, const vector<string>& expected, Sort sortBids) {
+    const int passes = 20;
+    double total = 0;
+    size_t copies = 0;
+    bool same = true;
+    for (int pass = 0; pass < passes; ++pass) {
+        vector<Bid> copy = bids;
+        size_t copiesBefore = Bid::copies.load();
+        double start = wallSeconds();
+        auto titleAt = sortBids(copy);
+        total += wallSeconds() - start;
+        copies += Bid::copies.load() - copiesBefore;
+        for (size_t i = 0; i < expected.size() && same; ++i) {
+            same = titleAt(i) == expected[i];
+        }
+    }
+    cout << name << ": " << total * 1e3 / passes << " ms, " << copies / passes << " bid copies"
+         << (same ? "" : " (ORDER DIFFERS)") << endl;
+}
+
+/**
+ * Compare quickSort against sorting small title keys and moving each bid
+ * once, or not moving the bids at all, on the CSV
+ */
+void benchmarkIndirectSort() {
+    vector<Bid> bids = VectorSort::loadBids(csvPath);
+    vector<string> expected;
+    for (const Bid& bid : bids) {
+        expected.push_back(bid.title);
+    }
+    sort(expected.begin(), expected.end());
+
+    cout << "\n" << bids.size() << " bids, average of 20 sorts" << endl;
+    timeTitleSort("quickSort               ", bids, expected, [](vector<Bid>& copy) {
+        VectorSort::quickSort(copy, 0, copy.size() - 1);
+        return [&copy](size_t i) -> const string& { return copy[i].title; };
+    });
+    timeTitleSort("std::sort on Bid        ", bids, expected, [](vector<Bid>& copy) {
+        sort(copy.begin(), copy.end(), [](const Bid& a, const Bid& b) { return a.title < b.title; });
+        return [&copy](size_t i) -> const string& { return copy[i].title; };
+    });
+    timeTitleSort("indirectSort            ", bids, expected, [](vector<Bid>& copy) {
+        VectorSort::indirectSort(copy);
+        return [&copy](size_t i) -> const string& { return copy[i].title; };
+    });
+    timeTitleSort("sortedOrder (view only) ", bids, expected, [](vector<Bid>& copy) {
+        auto order = make_shared<vector<unsigned int>>(VectorSort::sortedOrder(copy));
+        return [&copy, order](size_t i) -> const string& { return copy[(*order)[i]].title; };
+    });
+    cout << endl;
+}
+
+/**
+ * Sort a set of bids on title with quickSort, std::sort and the multikey
+ * quicksort, showing the time each takes and how much comparing it does.
+ * quickSort and std::sort are timed with a plain comparison and counted
+ * in a second run, since counting the bytes slows them down.
+ * @param name label printed with the results
+ * @param bids the unsorted bids
+ */
+void benchmarkTitleSortSize(const string& name, const vector<Bid>& bids) {
+    size_t strings = 0, bytes = 0;
+    auto counting = [&](const Bid& a, const Bid& b) {
+        const string& x = a.title;
+        const string& y = b.title;
+        size_t shorter = min(x.size(), y.size());
+        size_t same = mismatch(x.begin(), x.begin() + shorter, y.begin()).first - x.begin();
+        strings++;
+        bytes += same < shorter ? same + 1 : shorter;
+        return x < y;
+    };
+    auto byTitle = [](const Bid& a, const Bid& b) { return a.title < b.title; };
+
+    vector<Bid> sorted = bids;
+    double start = wallSeconds();
+    VectorSort::quickSort(sorted, 0, sorted.size() - 1);
+    double quickTime = wallSeconds() - start;
+    sorted = bids;
+    VectorSort::quickSort(sorted, 0, sorted.size() - 1, counting);
+    cout << name << " quickSort:    " << quickTime * 1e3 << " ms, " << strings << " title comparisons, "
+         << bytes << " bytes compared" << endl;
+
+    strings = bytes = 0;
+    sorted = bids;
+    start = wallSeconds();
+    sort(sorted.begin(), sorted.end(), byTitle);
+    double stdTime = wallSeconds() - start;
+    sorted = bids;
+    sort(sorted.begin(), sorted.end(), counting);
+    cout << name << " std::sort:    " << stdTime * 1e3 << " ms, " << strings << " title comparisons, "
+         << bytes << " bytes compared" << endl;
+
+    vector<Bid> multikey = bids;
+    size_t compared = 0;
+    start = wallSeconds();
+    VectorSort::multikeySort(multikey, &compared);
+    double multikeyTime = wallSeconds() - start;
+    bool same = true;
+    for (size_t i = 0; i < sorted.size() && same; ++i) {
+        same = multikey[i].title == sorted[i].title;
+    }
+    cout << name << " multikeySort: " << multikeyTime * 1e3 << " ms, " << compared << " bytes compared, "
+         << quickTime / multikeyTime << "x quickSort, " << stdTime / multikeyTime << "x std::sort"
+         << (same ? "" : " (ORDER DIFFERS)") << endl;
+}
+
+/**
+ * Compare sorting on title with whole string comparisons against the
+ * multikey quicksort, on the CSV and on 1M bids whose titles are CSV
+ * titles with a lot number added, so many share long starts
+ */
+void benchmarkTitleSort() {
+    vector<Bid> bids = VectorSort::loadBids(csvPath);
+    cout << endl;
+    benchmarkTitleSortSize("CSV", bids);
+
+    mt19937 random(42);
+    vector<Bid> synthetic;
+    for (unsigned int i = 0; i < 1000000; ++i) {
+        Bid bid = syntheticBid(i);
+        bid.title = bids[random() % bids.size()].title + " Lot " + to_string(random() % 1000);
+        synthetic.push_back(move(bid));
+    }
+    benchmarkTitleSortSize("1M ", synthetic);
+    cout << endl;
+}
+
+/**
+ * Make 1M bids whose titles come in a given pattern, fixed width lot
+ * numbers so title order matches number order
+ * @param pattern the order of the titles
+ */
+vector<Bid> patternBids(const string& pattern) {
+    const unsigned int size = 1000000;
+    mt19937 random(42);
+    vector<Bid> bids;
+    bids.reserve(size);
+    for (unsigned int i = 0; i < size; ++i) {
+        unsigned int lot;
+        if (pattern == "sorted") {
+            lot = i;
+        } else if (pattern == "reversed") {
+            lot = size - i;
+        } else if (pattern == "all equal") {
+            lot = 0;
+        } else if (pattern == "few distinct") {
+            lot = random() % 4;
+        } else if (pattern == "organ pipe") {
+            lot = i < size / 2 ? i : size - i;
+        } else if (pattern == "sorted + 10") {
+            lot = i % (size / 10) == 0 ? random() % size : i;
+        } else {
+            lot = random() % size;
+        }
+        Bid bid = syntheticBid(i);
+        char title[32];
+        snprintf(title, sizeof(title), "Dell Laptop %07u", lot);
+        bid.title = title;
+        bids.push_back(move(bid));
+    }
+    return bids;
+}
+
+/**
+ * Compare quickSort against std::sort on input that is already in order,
+ * in reverse, all the same, random and other patterns that trip up a
+ * quick sort with a fixed pivot
+ */
+void benchmarkSortPatterns() {
+    auto byTitle = [](const Bid& a, const Bid& b) { return a.title < b.title; };
+    cout << "\n1000000 bids" << endl;
+    for (const char* pattern : {"random", "sorted", "reversed", "all equal", "few distinct",
+                                "organ pipe", "sorted + 10"}) {
+        vector<Bid> bids = patternBids(pattern);
+        size_t comparisons = 0;
+        double start = wallSeconds();
+        VectorSort::quickSort(bids, 0, bids.size() - 1,
+                              [&](const Bid& a, const Bid& b) { comparisons++; return a.title < b.title; });
+        double quickTime = wallSeconds() - start;
+        bool sorted = is_sorted(bids.begin(), bids.end(), byTitle);
+
+        bids = patternBids(pattern);
+        start = wallSeconds();
+        sort(bids.begin(), bids.end(), byTitle);
+        double stdTime = wallSeconds() - start;
+
+        cout << setw(13) << pattern << ": quickSort " << quickTime * 1e3 << " ms (" << comparisons
+             << " comparisons" << (sorted ? "" : ", NOT SORTED") << "), std::sort " << stdTime * 1e3 << " ms"
+             << endl;
+    }
+    cout << endl;
+}
+
+/**
+ * Sort bids with a SortSpec and with a comparison written out by hand
+ * for the same fields, using both std::sort and quickSort, and check the
+ * two give the same order. Each time is the best of three runs.
+ * @param name label printed with the results
+ * @param bids the unsorted bids
+ * @param spec the sort spec
+ * @param byHand the hand written comparison
+ */
+template <typename Spec, typename ByHand>
+void compareSortSpec(const string& name, const vector<Bid>& bids, Spec spec, ByHand byHand) {
+    auto timeSort = [&](auto sortBids, vector<Bid>& sorted) {
+        sorted = bids;
+        double start = wallSeconds();
+        sortBids(sorted);
+        return wallSeconds() - start;
+    };
+    // best of three runs, taken in turns so both see the same machine
+    vector<Bid> bySpec, written;
+    double specStd = 1e9, handStd = 1e9, specQuick = 1e9, handQuick = 1e9;
+    for (int run = 0; run < 3; ++run) {
+        specStd = min(specStd, timeSort([&](vector<Bid>& v) { sort(v.begin(), v.end(), spec); }, bySpec));
+        handStd = min(handStd, timeSort([&](vector<Bid>& v) { sort(v.begin(), v.end(), byHand); }, written));
+        specQuick = min(specQuick, timeSort([&](vector<Bid>& v) {
+            VectorSort::quickSort(v, 0, v.size() - 1, spec);
+        }, bySpec));
+        handQuick = min(handQuick, timeSort([&](vector<Bid>& v) {
+            VectorSort::quickSort(v, 0, v.size() - 1, byHand);
+        }, written));
+    }
+
+    bool same = true;
+    for (size_t i = 0; i < bySpec.size() && same; ++i) {
+        same = !spec(bySpec[i], written[i]) && !spec(written[i], bySpec[i]);
+    }
+    cout << name << (same ? "" : " (ORDER DIFFERS)") << endl;
+    cout << "  std::sort  spec " << specStd * 1e3 << " ms, by hand " << handStd * 1e3 << " ms ("
+         << specStd / handStd << "x)" << endl;
+    cout << "  quickSort  spec " << specQuick * 1e3 << " ms, by hand " << handQuick * 1e3 << " ms ("
+         << specQuick / handQuick << "x)" << endl;
+}
+
+/**
+ * Show that sorting with a SortSpec costs no more than a comparison
+ * written by hand, on 1M bids drawn from the CSV
+ */
+void benchmarkSortSpec() {
+    vector<Bid> rows = VectorSort::loadBids(csvPath);
+    mt19937 random(42);
+    vector<Bid> bids;
+    for (int i = 0; i < 1000000; ++i) {
+        bids.push_back(rows[random() % rows.size()]);
+    }
+    cout << "\n" << bids.size() << " bids" << endl;
+
+    compareSortSpec("Fund, then largest winning bid", bids,
+        SortSpec<Ascending<FundField>, Descending<AmountField>>(),
+        [](const Bid& a, const Bid& b) {
+            int fund = a.fund.compare(b.fund);
+            return fund != 0 ? fund < 0 : a.amount > b.amount;
+        });
+    compareSortSpec("Paid date, then title", bids,
+        SortSpec<Ascending<DatePaidField>, Ascending<TitleField>>(),
+        [](const Bid& a, const Bid& b) {
+            uint32_t first = 0, second = 0;
+            packDate(a.datePaid, first);
+            packDate(b.datePaid, second);
+            return first != second ? first < second : a.title < b.title;
+        });
+    compareSortSpec("Title, then fund, then bid id", bids,
+        SortSpec<Ascending<TitleField>, Ascending<FundField>, Ascending<BidIdField>>(),
+        [](const Bid& a, const Bid& b) {
+            int title = a.title.compare(b.title);
+            if (title != 0) {
+                return title < 0;
+            }
+            int fund = a.fund.compare(b.fund);
+            if (fund != 0) {
+                return fund < 0;
+            }
+            if (a.bidId.size() != b.bidId.size()) {
+                return a.bidId.size() < b.bidId.size();
+            }
+            return a.bidId < b.bidId;
+        });
+    cout << endl;
+}
+
+/**
+ * Sort a set of bids by title with quickSort and with parallelSort on
+ * different numbers of threads, checking every sort gives the same titles
+ * @param name label printed with the results
+ * @param makeBids gives a new copy of the unsorted bids for each sort
+ */
+template <typename Generator>
+void benchmarkParallelSortSize(const string& name, Generator makeBids) {
+    vector<Bid> bids = makeBids();
+    double start = wallSeconds();
+    VectorSort::quickSort(bids, 0, bids.size() - 1);
+    double quickTime = wallSeconds() - start;
+    vector<string> expected;
+    for (const Bid& bid : bids) {
+        expected.push_back(bid.title);
+    }
+    cout << name << " quickSort " << quickTime * 1e3 << " ms" << endl;
+
+    for (unsigned int threads : {1u, 2u, 4u, 8u}) {
+        WorkStealingPool pool(threads);
+        bids = makeBids();
+        start = wallSeconds();
+        VectorSort::parallelSort(bids, pool);
+        double sortTime = wallSeconds() - start;
+
+        bool same = true;
+        for (size_t i = 0; i < bids.size() && same; ++i) {
+            same = bids[i].title == expected[i];
+        }
+        cout << name << " parallelSort, " << threads << (threads == 1 ? " thread:  " : " threads: ")
+             << sortTime * 1e3 << " ms, " << quickTime / sortTime << "x quickSort"
+             << (same ? "" : " (ORDER DIFFERS)") << endl;
+    }
+}
+
+/**
+ * Compare quickSort against parallelSort from the CSV up to 10M
+ * synthetic bids in a scrambled order
+ */
+void benchmarkParallelSort() {
+    cout << "\n" << thread::hardware_concurrency() << " hardware threads" << endl;
+    benchmarkParallelSortSize("CSV", [] { return VectorSort::loadBids(csvPath); });
+    for (unsigned int size : {100000u, 1000000u, 10000000u}) {
+        benchmarkParallelSortSize(to_string(size), [size] {
+            vector<Bid> bids;
+            bids.reserve(size);
+            for (unsigned int i = 0; i < size; ++i) {
+                bids.push_back(syntheticBid((i * 7919ull) % size));
+            }
+            return bids;
+        });
+    }
+    cout << endl;
+}
+
+/**
+ * Method used to run one of the benchmark menus
+ * @param entries label and benchmark of each option, numbered from 1
+ */
+void benchmarkSubmenu(const vector<pair<string, void (*)()>>& entries) {
+    int choice = 0;
+    while (choice != 9) {
+        cout << "Menu:" << endl;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            cout << "  " << i + 1 << ". " << entries[i].first << endl;
+        }
+        cout << "  9. Return to Benchmarks Menu" << endl;
+        cout << "Enter choice: ";
+        cin >> choice;
+
+        // if input is not int cin will fail and loop will runoff.
+        // if we have bad input it will clear cin to allow for input again
+        if (cin.fail()) {
+            // get rid of failure state
+            cin.clear();
+
+            // discard 'bad' character(s)
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+            continue;
+        }
+
+        if (choice >= 1 && choice <= int(entries.size())) {
+            entries[choice - 1].second();
+        } else if (choice != 9) {
+            cout << "!! Invalid Input Please Try Again !!" << endl;
+        }
+    }
+}
+
+/**
+ * Method used for the menu of benchmarks comparing the different ways
+ * the application can load and process the bids
+ */
+void benchmarkMenu() {
+    cout << "\nThese operations measure the time and memory used by the\n"
+            "different ways bids can be loaded and processed.\n\n";
+
+    int choice = 0;
+    while (choice != 9) {
+        cout << "Menu:" << endl;
+        cout << "  1. CSV Parsing" << endl;
+        cout << "  2. Bid Storage" << endl;
+        cout << "  3. Hash Tables" << endl;
+        cout << "  4. Trees and Lists" << endl;
+        cout << "  5. Sorting" << endl;
+        cout << "  9. Return to Main Menu" << endl;
+        cout << "Enter choice: ";
+        cin >> choice;
+
+        // if input is not int cin will fail and loop will runoff.
+        // if we have bad input it will clear cin to allow for input again
+        if (cin.fail()) {
+            // get rid of failure state
+            cin.clear();
+
+            // discard 'bad' character(s)
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+            continue;
+        }
+
+        switch (choice) {
+
+            // Benchmarks for reading the CSV
+            case 1:
+                benchmarkSubmenu({
+                    {"CSV Parser - Copying vs Memory Mapped", benchmarkMappedParser},
+                    {"CSV Reader - Streaming Memory vs File Size", benchmarkStreaming},
+                    {"CSV Parser - Multi-threaded Scaling", benchmarkParallelParser},
+                    {"CSV Tokenizer - Scalar vs SIMD", benchmarkTokenizer},
+                    {"CSV Parser - All Columns vs Bid Columns", benchmarkProjection},
+                    {"CSV Row - Header Copies vs Shared Schema", benchmarkSchema},
+                    {"Conversions - strToDouble vs Fixed Point", benchmarkConversions},
+                });
+                break;
+
+            // Benchmarks for how the bids are stored
+            case 2:
+                benchmarkSubmenu({
+                    {"Startup - CSV vs Binary Snapshot", benchmarkSnapshot},
+                    {"Bid Records - Bid vs CompactBid", benchmarkCompactBids},
+                    {"Bid Records - Bytes per Bid by Container", benchmarkContainerRecords},
+                    {"Bid Records - Copies per Load", benchmarkBidCopies},
+                });
+                break;
+
+            // Benchmarks for the hash table
+            case 3:
+                benchmarkSubmenu({
+                    {"Hash Table - Hit and Miss Latency by Size", benchmarkHashLookups},
+                    {"Hash Table - Search vs SearchBatch", benchmarkSearchBatch},
+                    {"Concurrent Hash Table - Stress Check", stressConcurrentHashTable},
+                    {"Concurrent Hash Table - Throughput by Threads", benchmarkConcurrentHashTable},
+                });
+                break;
+
+            // Benchmarks for the trees and lists
+            case 4:
+                benchmarkSubmenu({
+                    {"Linked List - Load and Search Time", benchmarkLinkedList},
+                    {"Binary Search Tree - Sorted vs Shuffled Input", benchmarkTreeBalance},
+                    {"B+ Tree - Lookups and Range Scans vs Binary Search Tree", benchmarkBPlusTree},
+                    {"Trees - Insert vs BulkLoad", benchmarkBulkLoads},
+                    {"Node Pools - Heap vs Pooled Nodes", benchmarkNodePools},
+                    {"Concurrent Skip List - Stress Check", stressConcurrentSkipList},
+                    {"Concurrent Skip List - Throughput by Threads", benchmarkConcurrentSkipList},
+                });
+                break;
+
+            // Benchmarks for sorting the bids
+            case 5:
+                benchmarkSubmenu({
+                    {"Parallel Sort - Scaling by Threads and Size", benchmarkParallelSort},
+                    {"Indirect Sort - Title Keys vs quickSort", benchmarkIndirectSort},
+                    {"Title Sort - Multikey Quicksort vs quickSort and std::sort", benchmarkTitleSort},
+                    {"Quick Sort - Sorted, Reversed, Equal and Random Input", benchmarkSortPatterns},
+                    {"Sort Specs - SortSpec vs Hand Written Comparison", benchmarkSortSpec},
+                });
+                break;
+
+            // Return to Main Menu found in main()
+            case 9:
+                break;
+
+            // Default case to catch bad input
+            default:
+                cout << "!! Invalid Input Please Try Again !!" << endl;
+                break;
+        }
+    }
+}
+
 /**
  * Main Menu for running the application
  *
  */
 int main(int argc, char* argv[]) {
+    // Convert the CSV to a binary snapshot and exit:
+    //   DS --convert [csv path] [snapshot path]
+    if (argc > 1 && string(argv[1]) == "--convert") {
+        string from = argc > 2 ? argv[2] : csvPath;
+        string to = argc > 3 ? argv[3] : snapshotPath;
+        try {
+            ticks = clock();
+            int numBids = BidSnapshot::Convert(from, to);
+            ticks = clock() - ticks;
+            cout << numBids << " bids written to " << to << endl;
+            printTime(ticks); // Method formats the time output
+        } catch (exception &e) {
+            cerr << e.what() << endl;
+            return 1;
+        }
+        return 0;
+    }
+
     // Welcome message explaining application to others
     cout << "This application takes a CSV holding information for\n "
             "almost 18,000 bids submitted to a municipal government\n"
@@ -527,6 +2459,7 @@ int main(int argc, char* argv[]) {
         cout << "Menu:" << endl;
         cout << "  1. Sort Methods" << endl;
         cout << "  2. Search and Insert Methods" << endl;
+        cout << "  3. Performance Benchmarks" << endl;
         cout << "  9. Exit" << endl;
         cout << "Enter choice: ";
         cin >> choice;
@@ -554,6 +2487,11 @@ int main(int argc, char* argv[]) {
                 searchMenu();
                 break;
 
+            // Menu for the performance benchmarks
+            case 3:
+                benchmarkMenu();
+                break;
+
             // Exit the application
             case 9:
                 break;